@@ -0,0 +1,310 @@
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <set>
+#include <cmath>
+
+#include <sys/resource.h>
+
+#include <nlohmann/json.hpp>
+
+#include "types.hpp"
+#include "json_problem_parser.hpp"
+#include "cut_optimization_solver.hpp"
+
+// Times parsing, solving and printing on seeded synthetic problems and writes one JSON
+// object per case to stdout, so runs of two builds can be diffed or loaded into a table.
+
+using json = nlohmann::json;
+
+namespace
+{
+    enum class Distribution
+    {
+        uniform,
+        // Mostly short pieces, many fit on one board
+        short_heavy,
+        // Mostly long pieces, one or two per board
+        long_heavy,
+    };
+
+    const char *name(Distribution distribution)
+    {
+        switch (distribution)
+        {
+        case Distribution::uniform:
+            return "uniform";
+        case Distribution::short_heavy:
+            return "short";
+        case Distribution::long_heavy:
+            return "long";
+        }
+        return "";
+    }
+
+    struct Shape
+    {
+        size_t sources;
+        size_t cuts;
+        int max_quantity;
+        Distribution distribution;
+    };
+
+    // A problem file in the format parse_problems reads. Sources are stock lengths of a
+    // foot multiple with a small discount for longer boards, cuts are to the eighth inch.
+    std::string generate(const Shape &shape, uint64_t seed)
+    {
+        std::mt19937_64 random(seed);
+        std::uniform_real_distribution<double> unit(0, 1);
+
+        std::vector<int> feet;
+        for (int length = 4; length <= 20; length++)
+        {
+            feet.push_back(length);
+        }
+        std::shuffle(feet.begin(), feet.end(), random);
+        feet.resize(std::min(shape.sources, feet.size()));
+
+        json sources = json::array();
+        double longest = 0;
+        for (int length : feet)
+        {
+            const double inches = 12.0 * length;
+            const double price = std::round(100 * inches * 0.045 * (1.05 - 0.01 * length + 0.1 * unit(random))) / 100;
+            sources.push_back({{"tag", "stock"}, {"name", std::to_string(length) + "ft"}, {"cost", price}, {"length", inches}});
+            longest = std::max(longest, inches);
+        }
+
+        std::set<double> lengths;
+        const double shortest = 6;
+        while (lengths.size() < shape.cuts)
+        {
+            double u = unit(random);
+            if (shape.distribution == Distribution::short_heavy)
+            {
+                u = u * u;
+            }
+            else if (shape.distribution == Distribution::long_heavy)
+            {
+                u = 1 - (1 - u) * (1 - u);
+            }
+            lengths.insert(std::round(8 * (shortest + u * (longest - shortest))) / 8);
+        }
+
+        std::uniform_int_distribution<int> quantity(1, shape.max_quantity);
+        json cuts = json::array();
+        for (double length : lengths)
+        {
+            cuts.push_back({{"tag", "stock"}, {"length", length}, {"quantity", quantity(random)}});
+        }
+
+        return json{{"resolution", 0.125}, {"sources", std::move(sources)}, {"cuts", std::move(cuts)}}.dump();
+    }
+
+    // Starts a fresh high-water mark for resident memory where the kernel allows it
+    void reset_peak_memory()
+    {
+        std::ofstream("/proc/self/clear_refs") << "5";
+    }
+
+    size_t peak_memory_kb()
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line))
+        {
+            if (line.rfind("VmHWM:", 0) == 0)
+            {
+                return std::stoul(line.substr(6));
+            }
+        }
+
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<size_t>(usage.ru_maxrss);
+    }
+
+    double milliseconds_since(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    bool parse_engine(std::string_view text, SolverEngine &engine)
+    {
+        const std::pair<std::string_view, SolverEngine> engines[] = {
+            {"best_first", SolverEngine::best_first},
+            {"column_generation", SolverEngine::column_generation},
+            {"patterns", SolverEngine::patterns},
+            {"parallel_branch_and_bound", SolverEngine::parallel_branch_and_bound},
+            {"iterative_deepening", SolverEngine::iterative_deepening},
+            {"beam", SolverEngine::beam},
+        };
+        for (const auto &[key, value] : engines)
+        {
+            if (key == text)
+            {
+                engine = value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool parse_open_list(std::string_view text, OpenList &open_list)
+    {
+        const std::pair<std::string_view, OpenList> open_lists[] = {
+            {"binary_heap", OpenList::binary_heap},
+            {"radix_heap", OpenList::radix_heap},
+        };
+        for (const auto &[key, value] : open_lists)
+        {
+            if (key == text)
+            {
+                open_list = value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    json run_case(const Shape &shape, uint64_t seed, SolverOptions options)
+    {
+        const std::string text = generate(shape, seed);
+
+        reset_peak_memory();
+
+        auto start = std::chrono::steady_clock::now();
+        Problems problems = parse_problems(text);
+        const double parse_ms = milliseconds_since(start);
+        Problem &problem = problems.front();
+
+        size_t pieces = 0;
+        for (const auto &cut : problem.cuts)
+        {
+            pieces += cut.quantity;
+        }
+
+        SolverStats stats;
+        options.stats = &stats;
+        std::vector<Source> sources = problem.sources;
+        std::vector<Cut> cuts = problem.cuts;
+        start = std::chrono::steady_clock::now();
+        const EndState solution = solve_cut_problem(sources, cuts, options);
+        const double solve_ms = milliseconds_since(start);
+
+        std::ostringstream sink;
+        start = std::chrono::steady_clock::now();
+        output(sink, problem, solution);
+        const double output_ms = milliseconds_since(start);
+
+        return {{"seed", seed},
+                {"sources", shape.sources},
+                {"cuts", shape.cuts},
+                {"max_quantity", shape.max_quantity},
+                {"distribution", name(shape.distribution)},
+                {"pieces", pieces},
+                {"parse_ms", parse_ms},
+                {"solve_ms", solve_ms},
+                {"output_ms", output_ms},
+                {"nodes", stats.nodes_expanded},
+                {"nodes_generated", stats.nodes_generated},
+                {"duplicates_pruned", stats.duplicates_pruned},
+                {"peak_queue_size", stats.peak_queue_size},
+                {"nodes_per_sec", solve_ms > 0 ? 1000 * stats.nodes_expanded / solve_ms : 0.0},
+                {"peak_rss_kb", peak_memory_kb()},
+                {"cost", solution.cost},
+                {"lower_bound", solution.lower_bound}};
+    }
+
+    void usage(const char *program)
+    {
+        std::cerr << "Usage: " << program << " [--engine <name>] [--open-list <binary_heap|radix_heap>] [--seed <n>] [--time-limit <ms>] [--memory-limit <MiB>]\n";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    SolverOptions options;
+    options.time_limit = std::chrono::milliseconds(1000);
+    options.memory_limit = size_t(1024) << 20;
+    uint64_t seed = 1;
+    std::string_view engine = "best_first";
+    std::string_view open_list = "radix_heap";
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        const std::string_view value = argv[++i];
+        if (arg == "--engine")
+        {
+            if (!parse_engine(value, options.engine))
+            {
+                usage(argv[0]);
+                return 1;
+            }
+            engine = value;
+        }
+        else if (arg == "--open-list")
+        {
+            if (!parse_open_list(value, options.open_list))
+            {
+                usage(argv[0]);
+                return 1;
+            }
+            open_list = value;
+        }
+        else if (arg == "--seed")
+        {
+            seed = std::stoull(std::string(value));
+        }
+        else if (arg == "--time-limit")
+        {
+            options.time_limit = std::chrono::milliseconds(std::stol(std::string(value)));
+        }
+        else if (arg == "--memory-limit")
+        {
+            options.memory_limit = std::stoull(std::string(value)) << 20;
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    const size_t source_counts[] = {2, 6};
+    const size_t cut_counts[] = {3, 6, 12};
+    const int max_quantities[] = {4, 16};
+    const Distribution distributions[] = {Distribution::uniform, Distribution::short_heavy, Distribution::long_heavy};
+
+    for (size_t sources : source_counts)
+    {
+        for (size_t cuts : cut_counts)
+        {
+            for (int max_quantity : max_quantities)
+            {
+                for (Distribution distribution : distributions)
+                {
+                    const Shape shape{sources, cuts, max_quantity, distribution};
+                    json row = run_case(shape, seed, options);
+                    row["engine"] = engine;
+                    row["open_list"] = open_list;
+                    std::cout << row.dump() << std::endl;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vector>
+
+#include "types.hpp"
+#include "cut_optimization_solver.hpp"
+
+// Rough size of a problem's search, only used to order a batch
+double estimate_difficulty(const Problem &problem);
+
+// Solves every problem of a batch on the TBB workers, largest estimate first, so the
+// longest solve starts at once and the small ones fill the other cores around it. Each
+// problem is solved by one worker with options.engine. Once fewer problems are left than
+// there are cores, a best-first solve races a parallel_branch_and_bound solve of the same
+// problem, whose tasks the workers left without a problem steal, and the first to prove
+// its plan stops the other. This needs options without on_incumbent, warm_start or
+// cancel. The plan is just as optimal, though it may be a different one of the same cost.
+// Solutions come back in the order of problems. When stats is given it is resized to hold
+// one entry per problem, from the best-first solve. An exception from any solve is
+// rethrown once every other solve has finished.
+std::vector<EndState> solve_problems(Problems &problems, const SolverOptions &options, std::vector<SolverStats> *stats = nullptr);
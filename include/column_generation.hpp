@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vector>
+
+#include "types.hpp"
+#include "cut_optimization_solver.hpp"
+#include "pattern_solver.hpp"
+
+struct LpRelaxation
+{
+    double cost;
+    std::vector<Pattern> patterns;
+    std::vector<double> usage;
+};
+
+// Solves the continuous relaxation of the cutting-stock problem by column generation.
+// Sources and cuts are expected sorted by length, as solve_cut_problem leaves them.
+LpRelaxation solve_lp_relaxation(const std::vector<Source> &sources, const std::vector<Cut> &cuts);
+
+// Rounds the relaxation to an integer plan, re-solving the leftover demand until it is all cut
+EndState solve_column_generation(const std::vector<Source> &sources, const std::vector<Cut> &cuts);
@@ -3,21 +3,32 @@
 #include <variant>
 #include <stack>
 #include <vector>
+#include <string>
+#include <utility>
 #include <iostream>
+#include <chrono>
+#include <functional>
+#include <atomic>
 
 #include "types.hpp"
 
 // Helper funcs
 using Operation = std::variant<Cut, Source>;
 
-std::ostream& operator<<(std::ostream& out, const Operation& operation);
-
 struct EndState;
+class SolutionCache;
+
+// One way a board is cut, the name points into the problem's source_names
+struct CutBlock
+{
+    Source source;
+    const std::string *source_name;
+    std::vector<Length> cut_lengths;
+};
 
 class Record : public std::stack<Operation, std::vector<Operation>>{
     friend Record operator+(const Record& a, const Record& b);
-    friend std::ostream& operator<<(std::ostream& out, const Record& state);
-    friend void output(std::ostream &out, const Problem &problem, const EndState &solution);
+    friend std::vector<std::pair<CutBlock, size_t>> group_blocks(const Problem &problem, const EndState &solution);
 
 };
 using CutList = std::vector<Cut>;
@@ -25,12 +36,132 @@ using CutList = std::vector<Cut>;
 struct EndState
 {
     float cost;
+    // No plan can cost less than this, equal to cost once the plan is proven optimal
+    float lower_bound = 0;
     Record operations;
 
     void operator+(const EndState& other);
-    friend std::ostream& operator<<(std::ostream& out, const EndState& state);
 };
 
-EndState solve_cut_problem(std::vector<Source> &sources, std::vector<Cut> &cuts);
+enum class SolverEngine
+{
+    // Exact best-first search over single cuts
+    best_first,
+    // Gilmore-Gomory LP relaxation rounded to a plan, fast but not proven optimal
+    column_generation,
+    // Exact best-first search over whole boards, using every maximal pattern of each source
+    patterns,
+    // Exact depth-first branch-and-bound over single cuts on every core, sharing the best plan found
+    parallel_branch_and_bound,
+    // Exact iterative deepening on the A* bound, memory grows with the plan length only
+    iterative_deepening,
+    // Keeps only the most promising states at each depth, fast but not proven optimal
+    beam,
+};
+
+// Priority queue of the best-first engine. Both pop the same nodes in the same order.
+enum class OpenList
+{
+    // std::priority_queue of node handles
+    binary_heap,
+    // Buckets on the bits of the bound, relying on A* bounds never falling below the last one popped
+    radix_heap,
+};
+
+// Filled in by solve_cut_problem, give each solve its own. Node and queue counters come
+// from the serial search engines only. Building with CUTLIST_SOLVER_STATS=0 compiles the
+// hooks out of the search loops and leaves every field at zero.
+struct SolverStats
+{
+    size_t nodes_generated = 0;
+    size_t nodes_expanded = 0;
+    // Children dropped because their state was already reached at the same cost or cheaper
+    size_t duplicates_pruned = 0;
+    size_t peak_queue_size = 0;
+    size_t peak_queue_bytes = 0;
+
+    // Wall time of each phase in milliseconds, sorting includes the pre-reduction
+    double sort_ms = 0;
+    double search_ms = 0;
+    double reconstruction_ms = 0;
+};
+
+struct SolverOptions
+{
+    SolverEngine engine = SolverEngine::best_first;
+
+
+    // Generate each cutting plan in one order only: cuts on a board are placed longest
+    // first and every new board starts with the longest cut still left
+    bool canonical_ordering = true;
+
+    // Order the search by cost so far plus a lower bound on the cost of the remaining demand
+    bool a_star = true;
+
+    OpenList open_list = OpenList::radix_heap;
+
+    // Let the patterns engine cut a pattern as many times as the open demand takes it
+    // whole in one step, so high quantities need as many steps as distinct patterns rather
+    // than boards. Plans that use a pattern fewer times are never tried, so the plan is not
+    // proven optimal and is never cached.
+    bool repeat_patterns = false;
+
+    // Worker threads for the parallel engine, 0 lets TBB use every core
+    unsigned threads = 0;
+
+    // Budget for the best-first, iterative deepening and parallel engines, 0 is unlimited.
+    // When it runs out the best plan found so far is returned with a lower bound on the optimum.
+    std::chrono::milliseconds time_limit{0};
+    size_t node_limit = 0;
+    // Set from another thread to end the search as if the budget had run out
+    const std::atomic<bool> *cancel = nullptr;
+    // Approximate bytes of search state. The best-first and parallel engines stop when it
+    // is reached, iterative deepening stops adding to its transposition table instead, and the beam
+    // engine narrows its beam so a layer fits and stops once its move trails fill it.
+    size_t memory_limit = 0;
+
+    // Relative optimality gap accepted, 0.005 takes any plan within 0.5% of the optimum.
+    // When it is set the best-first, iterative deepening and parallel engines bound the
+    // problem by its LP relaxation, drop nodes that cannot beat the incumbent by more than
+    // the gap and stop as soon as the incumbent is within it. The gap proven is reported
+    // through lower_bound.
+    float gap = 0;
+
+    // States kept at each depth by the beam engine
+    size_t beam_width = 1024;
+
+    // Called with every plan the serial engines find that beats the ones before it
+    std::function<void(const EndState &)> on_incumbent;
+
+    // A known plan the best-first engine starts from when it beats the greedy one
+    const EndState *warm_start = nullptr;
+
+    SolverStats *stats = nullptr;
+
+    // Checked before solving, proven-optimal plans are added to it afterwards
+    SolutionCache *cache = nullptr;
+};
+
+// Sorts sources and cuts by length in place, takes out what reduce_problem can fix up
+// front and searches the rest with the engine in options
+EndState solve_cut_problem(std::vector<Source> &sources, std::vector<Cut> &cuts, const SolverOptions &options = {});
+
+// The boards of a plan with identical ones counted together, shortest source first
+std::vector<std::pair<CutBlock, size_t>> group_blocks(const Problem &problem, const EndState &solution);
+
+// Formats the whole plan into a buffer reused by the calling thread, then writes it at once
+void output(std::ostream& out, const Problem& problem, const EndState& solution);
 
-void output(std::ostream& out, const Problem& problem, const EndState& solution);
\ No newline at end of file
+// The plan of output in a compact columnar form for machine consumers. Numbers are
+// little-endian, lengths are the integer ticks of the resolution the plan was solved in,
+// cuts rounded up and sources down, and a string is its u32 byte count followed by its bytes.
+// The B blocks are written as whole columns, one after the other, not as B records.
+//   "CLB1"                   magic
+//   string tag, f64 resolution, f32 cost, f32 lower_bound
+//   u32 S, then S sources    each a string name, f32 cost, i32 length
+//   u32 B                    blocks of identical boards
+//   B u32                    source index of each block
+//   B u32                    board count of each block
+//   B u32                    pieces per board of each block
+//   i32 piece lengths        each block's pieces in turn, as many as its pieces per board
+void output_binary(std::ostream& out, const Problem& problem, const EndState& solution);
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <vector>
+
+#include "types.hpp"
+#include "cut_optimization_solver.hpp"
+
+// Re-solves after a small change to the demand. cuts is the demand previous was solved
+// for and is updated in place by delta, whose quantities may be negative. Boards of the
+// previous plan whose pieces are all still wanted are kept as they are and only the
+// demand they leave open is solved with options. The LP relaxation of the whole new
+// demand is reported as the lower bound, so the gap shows what keeping the boards cost.
+// When options carry a time or node budget, the best-first engine then spends it on the
+// whole new demand, warm-started from that plan.
+EndState resolve_cut_problem(std::vector<Source> &sources, std::vector<Cut> &cuts, const std::vector<Cut> &delta,
+                             const EndState &previous, const SolverOptions &options = {});
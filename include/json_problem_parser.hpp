@@ -1,6 +1,7 @@
 #pragma once
 
 #include <filesystem>
+#include <chrono>
 
 #include "types.hpp"
 
@@ -14,5 +15,19 @@ public:
     inline problem_feasibility_exception(const std::string &c) : std::runtime_error(c) {}
 };
 
+// A problem document and the "id" it came with, kept as JSON text so it can be echoed
+// back untouched. Empty when the document has no id.
+struct ProblemDocument
+{
+    std::string id;
+    Problems problems;
+    // Solve budget the document asks for with "time_limit" in milliseconds, 0 when it sets none
+    std::chrono::milliseconds time_limit{0};
+    // Id of an earlier document to stop solving, sent as {"cancel": <id>}, as JSON text
+    std::string cancel;
+};
+
+ProblemDocument parse_problem_document(const std::string &str);
+
 Problems parse_problems(const std::string &str);
 Problems parse_problems(const std::filesystem::path &json_file);
\ No newline at end of file
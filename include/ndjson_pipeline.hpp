@@ -0,0 +1,19 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+#include "cut_optimization_solver.hpp"
+#include "json_problem_parser.hpp"
+
+// Reads one problem document per line and writes one solution line per document as soon
+// as it is solved, so lines come out in completion order. Each output line carries the
+// document's "id", or its line number when it has none. At most max_in_flight documents
+// are read ahead of the ones written.
+void run_ndjson_pipeline(std::istream &in, std::ostream &out, const SolverOptions &options, size_t max_in_flight);
+
+// The output line for a parsed document: every problem solved within the document's own
+// time_limit when it sets one, or the error solving it raised. id is JSON text.
+std::string solution_line(const std::string &id, ProblemDocument &document, const SolverOptions &options);
+
+std::string error_line(const std::string &id, const char *message);
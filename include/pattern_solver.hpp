@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+
+#include "types.hpp"
+#include "cut_optimization_solver.hpp"
+
+// One board of a source and how many pieces of each cut go on it
+struct Pattern
+{
+    size_t source;
+    std::vector<int> counts;
+};
+
+// Every maximal pattern of every source: no piece that is still demanded fits in what is left.
+// Patterns that also fit on a cheaper source are dropped. Sources are enumerated in parallel.
+std::vector<Pattern> enumerate_patterns(const std::vector<Source> &sources, const std::vector<Cut> &cuts);
+
+// Turns boards and how many times each is cut into operations, longest piece first,
+// cutting no more of a piece than the cuts ask for
+EndState expand_plan(const std::vector<Source> &sources, const std::vector<Cut> &cuts, const std::vector<std::pair<Pattern, int>> &plan);
+
+// Exact best-first search over whole boards drawn from the enumerated patterns.
+// Sources and cuts are expected sorted by length, as solve_cut_problem leaves them.
+// This is not an integer program over pattern counts: every step adds one board, so
+// the search is as deep as the plan has boards, and how often a pattern is used only
+// shows in how many steps pick it. High quantities therefore still mean deep searches.
+// With repeats every step cuts its pattern as many times as the open demand takes it
+// whole, so the search is about as deep as the distinct patterns used. That search is
+// not exact and the plan's lower_bound is only the estimate of the whole demand.
+EndState solve_patterns(const std::vector<Source> &sources, const std::vector<Cut> &cuts, bool repeats = false);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+#include "types.hpp"
+#include "cut_optimization_solver.hpp"
+
+// What is left to search once the boards some optimal plan is known to use are taken out
+struct ReducedProblem
+{
+    std::vector<Source> sources;
+    std::vector<Cut> cuts;
+    // Boards fixed up front, optimal for the pieces they hold
+    EndState fixed;
+};
+
+// Exact reductions applied before the search, each keeps at least one optimal plan:
+// - a source is dropped when another one at least as long costs no more
+// - a cut that leaves no room for any other piece even on the longest source gets
+//   boards of its own, each the cheapest source that holds it
+// - when the cheapest source holding the longest cut left also holds all the demand
+//   left, that one board finishes the plan
+// Sources and cuts are expected sorted by length, as solve_cut_problem leaves them.
+ReducedProblem reduce_problem(const std::vector<Source> &sources, const std::vector<Cut> &cuts);
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <filesystem>
+
+#include "cut_optimization_solver.hpp"
+
+// Serves the NDJSON protocol of run_ndjson_pipeline on a Unix domain socket until the
+// process ends. Each connection sends one problem document per line and gets one line
+// back per document as soon as it is solved. A document may set "time_limit" in
+// milliseconds for its own solve, and {"cancel": <id>} stops the search of an earlier
+// document on the same connection, which then answers with the best plan found so far.
+// Closing a connection cancels whatever it still has in flight. A document that cannot
+// be read or solved is answered with an error line and never stops the server. Solves of
+// every connection share one pool of options.threads workers and options.cache; without a
+// cache the server keeps proven-optimal plans in memory for as long as it runs. Pattern
+// lists are not kept, only the patterns engine enumerates them and a plan it proves is
+// cached like any other.
+void run_socket_server(const std::filesystem::path &socket_path, const SolverOptions &options);
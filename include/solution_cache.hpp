@@ -0,0 +1,48 @@
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+#include "types.hpp"
+#include "cut_optimization_solver.hpp"
+
+// Proven-optimal plans kept on disk, one file per problem named by a hash of its sorted
+// sources and cuts. The stored problem is compared in full on a hit, so a hash collision
+// is only a miss. Once the files pass max_bytes the least recently used are deleted.
+// Safe to share between threads; other processes may use the same directory.
+class SolutionCache
+{
+public:
+    SolutionCache(std::filesystem::path directory, size_t max_bytes);
+
+    // The same entries kept in this process's memory only, for a server without a directory
+    explicit SolutionCache(size_t max_bytes);
+
+    std::optional<EndState> find(const std::vector<Source> &sources, const std::vector<Cut> &cuts);
+
+    // Plans that are not proven optimal are not kept, a later exact solve could beat them
+    void store(const std::vector<Source> &sources, const std::vector<Cut> &cuts, const EndState &solution);
+
+private:
+    struct MemoryEntry
+    {
+        std::string contents;
+        uint64_t used;
+    };
+
+    void evict();
+    void evict_memory();
+
+    // Empty when the entries are kept in memory
+    const std::filesystem::path directory;
+    const size_t max_bytes;
+    size_t total_bytes;
+    std::mutex mutex;
+    std::unordered_map<std::string, MemoryEntry> memory;
+    uint64_t uses = 0;
+};
@@ -4,16 +4,29 @@
 #include <iostream>
 #include <unordered_map>
 #include <bit>
+#include <cstdint>
+
+// Lengths are whole multiples of the problem's resolution, so fit checks and
+// state hashes are exact no matter how the input was written
+using Length = int32_t;
+
+// Lengths are rounded to this many input units unless the file sets "resolution"
+constexpr double default_resolution = 1.0 / 64;
+
+inline double to_units(Length length, double resolution)
+{
+    return length * resolution;
+}
 
 struct Source
 {
     float cost;
-    float length;
+    Length length;
 };
 
 struct Cut
 {
-    float length;
+    Length length;
     int quantity;
 };
 
@@ -123,18 +136,28 @@ namespace std
 struct Problem
 {
     std::string tag;
+    // Input units per Length tick
+    double resolution = default_resolution;
     std::unordered_map<Source, std::string> source_names;
+    // Lengths as the input wrote them, by the tick each was rounded to. Cuts round up and
+    // sources down so every plan can be cut, but plans print what was asked for.
+    std::unordered_map<Length, double> written_source_lengths;
+    std::unordered_map<Length, double> written_cut_lengths;
     std::vector<Source> sources;
     std::vector<Cut> cuts;
 };
 
-void output(std::ostream &out, const Source &src, const std::string &name);
+// A length of the problem in input units, as written when the input gave it
+double source_units(const Problem &problem, Length length);
+double cut_units(const Problem &problem, Length length);
 
-std::ostream &operator<<(std::ostream &out, const Problem &problem);
+// Length is in input units
+void output(std::ostream &out, const Source &src, const std::string &name, double length);
 
-std::ostream &operator<<(std::ostream &out, const Cut &cut);
+void output(std::ostream &out, const Cut &cut, double length);
 
-std::ostream &operator<<(std::ostream &out, const Source &src);
+// Lengths of a Cut or Source alone are ticks, so they are only printed through a Problem
+std::ostream &operator<<(std::ostream &out, const Problem &problem);
 
 using Problems = std::vector<Problem>;
 
@@ -0,0 +1,158 @@
+#include "batch_solver.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <limits>
+#include <numeric>
+
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
+
+double estimate_difficulty(const Problem &problem)
+{
+    double pieces = 0;
+    for (const auto &cut : problem.cuts)
+    {
+        pieces += cut.quantity;
+    }
+    // Every piece is a level of the search and branches over the distinct cuts and sources
+    return pieces * static_cast<double>(problem.cuts.size() + problem.sources.size());
+}
+
+namespace
+{
+    bool proven(const EndState &plan)
+    {
+        return plan.lower_bound >= plan.cost;
+    }
+
+    // The parallel engine proves the same optimum as best-first but neither reports
+    // incumbents nor starts from a warm plan, and a race needs a cancel flag of its own
+    bool can_race(const SolverOptions &options)
+    {
+        return options.engine == SolverEngine::best_first && !options.on_incumbent && !options.warm_start && !options.cancel;
+    }
+
+    // Best-first on this worker against parallel_branch_and_bound in tasks the idle workers
+    // steal. Whichever proves its plan first stops the other, and a search stopped by its
+    // budget keeps the cheaper plan with the better of the two bounds.
+    EndState race(Problem &problem, const SolverOptions &options)
+    {
+        std::atomic<bool> settled{false};
+        std::vector<Source> sources = problem.sources;
+        std::vector<Cut> cuts = problem.cuts;
+        SolverOptions parallel_options = options;
+        parallel_options.engine = SolverEngine::parallel_branch_and_bound;
+        parallel_options.threads = 0;
+        parallel_options.cancel = &settled;
+        parallel_options.stats = nullptr;
+
+        EndState parallel{std::numeric_limits<float>::infinity(), 0, {}};
+        tbb::task_group group;
+        group.run([&]
+                  {
+                      // Left queued until best-first was done, no worker was free
+                      if (settled.load(std::memory_order_relaxed))
+                      {
+                          return;
+                      }
+                      parallel = solve_cut_problem(sources, cuts, parallel_options);
+                      if (proven(parallel))
+                      {
+                          settled.store(true, std::memory_order_relaxed);
+                      } });
+
+        SolverOptions serial_options = options;
+        serial_options.cancel = &settled;
+        EndState serial;
+        std::exception_ptr error;
+        try
+        {
+            serial = solve_cut_problem(problem.sources, problem.cuts, serial_options);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        settled.store(true, std::memory_order_relaxed);
+
+        // Both solve the same problem, a failure of the parallel search alone leaves best-first's plan
+        try
+        {
+            group.wait();
+        }
+        catch (...)
+        {
+            parallel.cost = std::numeric_limits<float>::infinity();
+        }
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+
+        const float lower_bound = std::max(serial.lower_bound, parallel.lower_bound);
+        EndState &best = parallel.cost < serial.cost ? parallel : serial;
+        best.lower_bound = std::min(best.cost, lower_bound);
+        return std::move(best);
+    }
+}
+
+std::vector<EndState> solve_problems(Problems &problems, const SolverOptions &options, std::vector<SolverStats> *stats)
+{
+    std::vector<EndState> solutions(problems.size());
+    std::vector<std::exception_ptr> errors(problems.size());
+    if (stats)
+    {
+        stats->assign(problems.size(), SolverStats{});
+    }
+
+    std::vector<double> difficulty(problems.size());
+    std::transform(problems.begin(), problems.end(), difficulty.begin(), estimate_difficulty);
+    std::vector<size_t> order(problems.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                     { return difficulty[a] > difficulty[b]; });
+
+    // Each worker takes the largest problem still queued when it is free
+    std::atomic<size_t> next{0};
+    const size_t cores = tbb::this_task_arena::max_concurrency();
+    const size_t workers = std::min<size_t>(problems.size(), cores);
+    tbb::parallel_for(size_t(0), workers, [&](size_t)
+                      {
+                          for (size_t taken; (taken = next.fetch_add(1)) < order.size();)
+                          {
+                              const size_t i = order[taken];
+                              SolverOptions problem_options = options;
+                              if (stats)
+                              {
+                                  problem_options.stats = &(*stats)[i];
+                              }
+                              try
+                              {
+                                  // Too few problems are left to keep every core busy, the idle ones join in
+                                  if (order.size() - taken < cores && can_race(options))
+                                  {
+                                      solutions[i] = race(problems[i], problem_options);
+                                  }
+                                  else
+                                  {
+                                      solutions[i] = solve_cut_problem(problems[i].sources, problems[i].cuts, problem_options);
+                                  }
+                              }
+                              catch (...)
+                              {
+                                  errors[i] = std::current_exception();
+                              }
+                          } });
+
+    for (const auto &error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+    return solutions;
+}
@@ -0,0 +1,489 @@
+#include "column_generation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    constexpr double epsilon = 1e-9;
+
+    // Bounded knapsack used for pricing: the most dual value that fits on one board
+    class PatternPricer
+    {
+    public:
+        PatternPricer(const std::vector<Cut> &cuts_, const std::vector<int> &demand_) : cuts(cuts_), demand(demand_) {}
+
+        double best_pattern(Length capacity, const std::vector<double> &duals, std::vector<int> &counts)
+        {
+            order.clear();
+            for (size_t i = 0; i < cuts.size(); i++)
+            {
+                if (duals[i] > epsilon && demand[i] > 0)
+                {
+                    order.push_back(i);
+                }
+            }
+            // Densest items first so the fractional bound is tight
+            std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                      { return duals[a] * cuts[b].length > duals[b] * cuts[a].length; });
+
+            values = &duals;
+            current.assign(cuts.size(), 0);
+            best.assign(cuts.size(), 0);
+            best_value = 0;
+            search(0, capacity, 0);
+
+            counts = best;
+            return best_value;
+        }
+
+    private:
+        void search(size_t depth, Length capacity, double value)
+        {
+            if (value > best_value + epsilon)
+            {
+                best_value = value;
+                best = current;
+            }
+            if (depth == order.size())
+            {
+                return;
+            }
+
+            const size_t item = order[depth];
+            const Length length = cuts[item].length;
+            const double item_value = (*values)[item];
+
+            // Nothing further down can beat the incumbent even if cut fractionally
+            if (length > 0 && value + capacity * item_value / length <= best_value + epsilon)
+            {
+                return;
+            }
+
+            int most = demand[item];
+            if (length > 0)
+            {
+                most = std::min<int>(most, capacity / length);
+            }
+
+            for (int count = most; count >= 0; count--)
+            {
+                current[item] = count;
+                search(depth + 1, capacity - count * length, value + count * item_value);
+            }
+            current[item] = 0;
+        }
+
+        const std::vector<Cut> &cuts;
+        const std::vector<int> &demand;
+        const std::vector<double> *values = nullptr;
+        std::vector<size_t> order;
+        std::vector<int> current;
+        std::vector<int> best;
+        double best_value = 0;
+    };
+
+    // Revised simplex over min c.x subject to A.x >= d, x >= 0 with an explicit basis inverse.
+    // The number of rows is the number of distinct cut lengths, so a dense inverse is cheap.
+    class ColumnGeneration
+    {
+    public:
+        ColumnGeneration(const std::vector<Source> &sources_, const std::vector<Cut> &cuts_, const std::vector<int> &demand_)
+            : sources(sources_), cuts(cuts_), demand(demand_), rows(cuts_.size()), pricer(cuts_, demand_) {}
+
+        LpRelaxation solve()
+        {
+            initial_basis();
+
+            std::vector<double> duals(rows);
+            std::vector<double> direction(rows);
+            std::vector<int> counts;
+
+            for (size_t iteration = 0;; iteration++)
+            {
+                if (iteration % refactor_interval == refactor_interval - 1)
+                {
+                    refactor();
+                }
+
+                compute_duals(duals);
+
+                // Surplus columns are -e_i with no cost, they enter when a dual goes negative
+                size_t entering = no_column;
+                for (size_t i = 0; i < rows; i++)
+                {
+                    if (duals[i] < -epsilon)
+                    {
+                        entering = surplus_column(i);
+                        break;
+                    }
+                }
+
+                if (entering == no_column)
+                {
+                    double most_negative = -epsilon;
+                    for (size_t s = 0; s < sources.size(); s++)
+                    {
+                        const double value = pricer.best_pattern(sources[s].length, duals, counts);
+                        const double reduced_cost = sources[s].cost - value;
+                        if (reduced_cost < most_negative * std::max(1.0, static_cast<double>(sources[s].cost)))
+                        {
+                            most_negative = reduced_cost;
+                            entering = patterns.size();
+                            candidate = Pattern{s, counts};
+                        }
+                    }
+                    if (entering == no_column)
+                    {
+                        break;
+                    }
+                    patterns.push_back(candidate);
+                }
+
+                load_column(entering);
+                for (size_t i = 0; i < rows; i++)
+                {
+                    double sum = 0;
+                    for (size_t k = 0; k < rows; k++)
+                    {
+                        sum += inverse[i * rows + k] * entering_column[k];
+                    }
+                    direction[i] = sum;
+                }
+
+                size_t leaving = rows;
+                double step = std::numeric_limits<double>::infinity();
+                for (size_t i = 0; i < rows; i++)
+                {
+                    if (direction[i] > epsilon)
+                    {
+                        const double ratio = values[i] / direction[i];
+                        if (ratio < step - epsilon || (ratio < step + epsilon && leaving < rows && basis[i] < basis[leaving]))
+                        {
+                            step = ratio;
+                            leaving = i;
+                        }
+                    }
+                }
+                if (leaving == rows)
+                {
+                    throw std::runtime_error("Cutting-stock relaxation is unbounded, a source has no cost");
+                }
+
+                pivot(leaving, entering, direction, step);
+            }
+
+            LpRelaxation relaxation;
+            relaxation.cost = 0;
+            for (size_t i = 0; i < rows; i++)
+            {
+                if (basis[i] < patterns.size() && values[i] > epsilon)
+                {
+                    relaxation.cost += values[i] * sources[patterns[basis[i]].source].cost;
+                    relaxation.patterns.push_back(patterns[basis[i]]);
+                    relaxation.usage.push_back(values[i]);
+                }
+            }
+            return relaxation;
+        }
+
+    private:
+        static constexpr size_t no_column = std::numeric_limits<size_t>::max();
+        static constexpr size_t refactor_interval = 64;
+
+        // Surplus variables are numbered after every pattern that can ever be added
+        size_t surplus_column(size_t row) const
+        {
+            return no_column - rows + row;
+        }
+
+        double column_cost(size_t index) const
+        {
+            return index < patterns.size() ? sources[patterns[index].source].cost : 0.0;
+        }
+
+        void load_column(size_t index)
+        {
+            entering_column.assign(rows, 0);
+            if (index < patterns.size())
+            {
+                for (size_t i = 0; i < rows; i++)
+                {
+                    entering_column[i] = patterns[index].counts[i];
+                }
+            }
+            else
+            {
+                entering_column[index - surplus_column(0)] = -1;
+            }
+        }
+
+        // One pattern per cut: as many pieces of it as fit on the cheapest board per piece
+        void initial_basis()
+        {
+            patterns.clear();
+            basis.assign(rows, 0);
+            values.assign(rows, 0);
+            inverse.assign(rows * rows, 0);
+
+            for (size_t i = 0; i < rows; i++)
+            {
+                size_t best_source = sources.size();
+                int best_count = 0;
+                for (size_t s = 0; s < sources.size(); s++)
+                {
+                    if (sources[s].length < cuts[i].length)
+                    {
+                        continue;
+                    }
+                    int count = std::max(1, demand[i]);
+                    if (cuts[i].length > 0)
+                    {
+                        count = std::min<int>(count, sources[s].length / cuts[i].length);
+                    }
+                    if (best_source == sources.size() ||
+                        sources[s].cost * best_count < sources[best_source].cost * count)
+                    {
+                        best_source = s;
+                        best_count = count;
+                    }
+                }
+                if (best_source == sources.size())
+                {
+                    throw std::runtime_error("There is a cut that is longer than the longest source");
+                }
+
+                Pattern pattern{best_source, std::vector<int>(rows, 0)};
+                pattern.counts[i] = best_count;
+                patterns.push_back(pattern);
+
+                basis[i] = i;
+                values[i] = static_cast<double>(demand[i]) / best_count;
+                inverse[i * rows + i] = 1.0 / best_count;
+            }
+        }
+
+        void compute_duals(std::vector<double> &duals) const
+        {
+            for (size_t k = 0; k < rows; k++)
+            {
+                double sum = 0;
+                for (size_t i = 0; i < rows; i++)
+                {
+                    sum += column_cost(basis[i]) * inverse[i * rows + k];
+                }
+                duals[k] = sum;
+            }
+        }
+
+        void pivot(size_t leaving, size_t entering, const std::vector<double> &direction, double step)
+        {
+            for (size_t i = 0; i < rows; i++)
+            {
+                values[i] -= step * direction[i];
+            }
+            values[leaving] = step;
+
+            const double pivot_value = direction[leaving];
+            for (size_t k = 0; k < rows; k++)
+            {
+                inverse[leaving * rows + k] /= pivot_value;
+            }
+            for (size_t i = 0; i < rows; i++)
+            {
+                if (i == leaving || direction[i] == 0)
+                {
+                    continue;
+                }
+                for (size_t k = 0; k < rows; k++)
+                {
+                    inverse[i * rows + k] -= direction[i] * inverse[leaving * rows + k];
+                }
+            }
+            basis[leaving] = entering;
+        }
+
+        // Rebuilds the inverse from the basis columns to wash out accumulated rounding
+        void refactor()
+        {
+            std::vector<double> matrix(rows * rows, 0);
+            for (size_t i = 0; i < rows; i++)
+            {
+                load_column(basis[i]);
+                for (size_t k = 0; k < rows; k++)
+                {
+                    matrix[k * rows + i] = entering_column[k];
+                }
+            }
+
+            inverse.assign(rows * rows, 0);
+            for (size_t i = 0; i < rows; i++)
+            {
+                inverse[i * rows + i] = 1;
+            }
+
+            for (size_t col = 0; col < rows; col++)
+            {
+                size_t pivot_row = col;
+                for (size_t r = col + 1; r < rows; r++)
+                {
+                    if (std::fabs(matrix[r * rows + col]) > std::fabs(matrix[pivot_row * rows + col]))
+                    {
+                        pivot_row = r;
+                    }
+                }
+                if (std::fabs(matrix[pivot_row * rows + col]) < epsilon)
+                {
+                    return; // Keep the incrementally updated inverse
+                }
+                for (size_t k = 0; k < rows; k++)
+                {
+                    std::swap(matrix[col * rows + k], matrix[pivot_row * rows + k]);
+                    std::swap(inverse[col * rows + k], inverse[pivot_row * rows + k]);
+                }
+                const double scale = matrix[col * rows + col];
+                for (size_t k = 0; k < rows; k++)
+                {
+                    matrix[col * rows + k] /= scale;
+                    inverse[col * rows + k] /= scale;
+                }
+                for (size_t r = 0; r < rows; r++)
+                {
+                    const double factor = matrix[r * rows + col];
+                    if (r == col || factor == 0)
+                    {
+                        continue;
+                    }
+                    for (size_t k = 0; k < rows; k++)
+                    {
+                        matrix[r * rows + k] -= factor * matrix[col * rows + k];
+                        inverse[r * rows + k] -= factor * inverse[col * rows + k];
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < rows; i++)
+            {
+                double sum = 0;
+                for (size_t k = 0; k < rows; k++)
+                {
+                    sum += inverse[i * rows + k] * demand[k];
+                }
+                values[i] = std::max(0.0, sum);
+            }
+        }
+
+        const std::vector<Source> &sources;
+        const std::vector<Cut> &cuts;
+        const std::vector<int> &demand;
+        const size_t rows;
+        PatternPricer pricer;
+
+        std::vector<Pattern> patterns;
+        Pattern candidate;
+        std::vector<size_t> basis;
+        std::vector<double> values;
+        std::vector<double> inverse;
+        std::vector<double> entering_column;
+    };
+
+    LpRelaxation relax(const std::vector<Source> &sources, const std::vector<Cut> &cuts, const std::vector<int> &demand)
+    {
+        return ColumnGeneration(sources, cuts, demand).solve();
+    }
+
+    // Drops pieces that are no longer needed and moves the board to the cheapest source that still holds it
+    void trim(Pattern &pattern, const std::vector<Source> &sources, const std::vector<Cut> &cuts, const std::vector<int> &remaining)
+    {
+        int64_t used = 0;
+        for (size_t i = 0; i < cuts.size(); i++)
+        {
+            pattern.counts[i] = std::min(pattern.counts[i], remaining[i]);
+            used += static_cast<int64_t>(pattern.counts[i]) * cuts[i].length;
+        }
+
+        for (size_t s = 0; s < sources.size(); s++)
+        {
+            if (sources[s].length >= used && sources[s].cost < sources[pattern.source].cost)
+            {
+                pattern.source = s;
+            }
+        }
+    }
+}
+
+LpRelaxation solve_lp_relaxation(const std::vector<Source> &sources, const std::vector<Cut> &cuts)
+{
+    std::vector<int> demand(cuts.size());
+    for (size_t i = 0; i < cuts.size(); i++)
+    {
+        demand[i] = cuts[i].quantity;
+    }
+    return relax(sources, cuts, demand);
+}
+
+EndState solve_column_generation(const std::vector<Source> &sources, const std::vector<Cut> &cuts)
+{
+    std::vector<int> remaining(cuts.size());
+    for (size_t i = 0; i < cuts.size(); i++)
+    {
+        remaining[i] = cuts[i].quantity;
+    }
+
+    std::vector<std::pair<Pattern, int>> plan;
+    float lower_bound = 0;
+
+    while (std::any_of(remaining.begin(), remaining.end(), [](int quantity)
+                       { return quantity > 0; }))
+    {
+        LpRelaxation relaxation = relax(sources, cuts, remaining);
+        if (plan.empty())
+        {
+            lower_bound = static_cast<float>(relaxation.cost);
+        }
+
+        bool progressed = false;
+        for (size_t p = 0; p < relaxation.patterns.size(); p++)
+        {
+            int uses = static_cast<int>(std::floor(relaxation.usage[p] + epsilon));
+            Pattern &pattern = relaxation.patterns[p];
+            for (size_t i = 0; i < cuts.size() && uses > 0; i++)
+            {
+                if (pattern.counts[i] > 0)
+                {
+                    uses = std::min(uses, remaining[i] / pattern.counts[i]);
+                }
+            }
+            if (uses <= 0)
+            {
+                continue;
+            }
+
+            for (size_t i = 0; i < cuts.size(); i++)
+            {
+                remaining[i] -= pattern.counts[i] * uses;
+            }
+            plan.emplace_back(pattern, uses);
+            progressed = true;
+        }
+
+        // Every pattern is used fractionally: round the busiest one up once and re-solve the rest
+        if (!progressed)
+        {
+            const size_t busiest = std::max_element(relaxation.usage.begin(), relaxation.usage.end()) - relaxation.usage.begin();
+            Pattern pattern = relaxation.patterns[busiest];
+            trim(pattern, sources, cuts, remaining);
+            for (size_t i = 0; i < cuts.size(); i++)
+            {
+                remaining[i] -= pattern.counts[i];
+            }
+            plan.emplace_back(pattern, 1);
+        }
+    }
+
+    EndState end_state = expand_plan(sources, cuts, plan);
+    end_state.lower_bound = std::min(lower_bound, end_state.cost);
+    return end_state;
+}
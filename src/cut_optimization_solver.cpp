@@ -1,8 +1,33 @@
 #include "cut_optimization_solver.hpp"
+#include "column_generation.hpp"
+#include "pattern_solver.hpp"
+#include "solution_cache.hpp"
+#include "problem_reduction.hpp"
 
 #include <unordered_map>
 #include <queue>
 #include <functional>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <optional>
+#include <cstdint>
+#include <chrono>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <charconv>
+#include <cstring>
+#include <bit>
+#include <memory_resource>
+
+#include <tbb/concurrent_hash_map.h>
+#include <tbb/parallel_for_each.h>
+#include <tbb/task_arena.h>
+
+#ifndef CUTLIST_SOLVER_STATS
+#define CUTLIST_SOLVER_STATS 1
+#endif
 
 Record operator+(const Record &a, const Record &b)
 {
@@ -21,286 +46,1564 @@ Record operator+(const Record &a, const Record &b)
 void EndState::operator+(const EndState &other)
 {
     this->cost += other.cost;
+    this->lower_bound += other.lower_bound;
     this->operations = this->operations + other.operations;
 }
 
-std::ostream &operator<<(std::ostream &out, const Record &state)
+namespace
 {
-    const std::vector<Operation> &vec = state.c;
-    out << '[';
-    for (size_t i = 0; i < vec.size(); i++)
+    struct CutLengthSorter
     {
-        out << vec[i];
-        if (i != vec.size() - 1)
+        constexpr bool operator()(const Cut &a, const Cut &b) const
         {
-            out << ", ";
+            return a.length < b.length;
         }
-    }
-    out << ']';
-    return out;
-}
+    };
 
-std::ostream &operator<<(std::ostream &out, const Operation &operation)
-{
-    if (const Cut *cut = std::get_if<Cut>(&operation))
-    {
-        out << *cut;
-    }
-    else if (const Source *src_ = std::get_if<Source>(&operation))
+    struct SourceLengthSorter
     {
-        const Source &src = *src_;
-        out << src;
-    }
-    else
+        constexpr bool operator()(const Source &a, const Source &b) const
+        {
+            return a.length < b.length;
+        }
+    };
+
+    // The part of a search state that decides how it can be finished:
+    // the demand still open, the offcut left on the current board and the
+    // longest cut that may still go on it. Once nothing more fits the board
+    // is finished and both are zeroed, so all finished boards with the same
+    // demand share one key.
+    // A key copies its cut list into the memory resource of the key it is made
+    // from, so every state of a search lives in the resource its root was built in.
+    struct SearchKey
     {
-        out << "null";
-    }
-    return out;
-}
+        SearchKey(const CutList &cuts_, std::pmr::memory_resource *resource)
+            : cuts(cuts_.begin(), cuts_.end(), resource), length(0), cap(0) {}
 
-std::ostream &operator<<(std::ostream &out, const EndState &state)
-{
-    out << "{\"cost\": " << state.cost << ",\n";
-    out << "\"operations\": " << state.operations;
-    out << '}';
-    return out;
+        SearchKey(const std::pmr::vector<Cut> &cuts_, Length length_, Length cap_)
+            : cuts(cuts_, cuts_.get_allocator()), length(length_), cap(cap_) {}
+
+        SearchKey(const SearchKey &other) : SearchKey(other.cuts, other.length, other.cap) {}
+        SearchKey(SearchKey &&) = default;
+        SearchKey &operator=(const SearchKey &) = default;
+        SearchKey &operator=(SearchKey &&) = default;
+
+        std::pmr::vector<Cut> cuts;
+        Length length;
+        Length cap;
+    };
 }
 
-namespace
+namespace std
 {
-    struct CutLengthSorter
+    template <>
+    struct hash<SearchKey>
     {
-        constexpr bool operator()(const Cut &a, const Cut &b) const
+        size_t operator()(const SearchKey &key) const
         {
-            return a.length < b.length;
+            size_t seed = 6875769686;
+            for (const auto &cut : key.cuts)
+            {
+                hash_combine(seed, cut);
+            }
+            hash_combine(seed, key.length);
+            hash_combine(seed, key.cap);
+            return seed;
         }
     };
 
-    struct SourceLengthSorter
+    template <>
+    struct equal_to<SearchKey>
     {
-        constexpr bool operator()(const Source &a, const Source &b) const
+        bool operator()(const SearchKey &a, const SearchKey &b) const
         {
-            return a.length < b.length;
+            return a.length == b.length && a.cap == b.cap &&
+                   std::equal(a.cuts.begin(), a.cuts.end(), b.cuts.begin(), b.cuts.end(), std::equal_to<Cut>{});
         }
     };
+}
+
+namespace
+{
+    // One step of a plan inside the search: the index of a cut in the root cut list,
+    // or of a source with the high bit set. Steps are decoded to Operations only when
+    // the plan an engine returns is rebuilt.
+    using PlanStep = uint16_t;
+
+    constexpr PlanStep source_step = 0x8000;
+
+    // A search node only remembers the step that created it, where it came from and
+    // the interned state it reached, so every node has the same size no matter how
+    // deep in the search it sits. The full Record is rebuilt from the parent chain.
+    struct Node
+    {
+        static constexpr uint32_t no_parent = std::numeric_limits<uint32_t>::max();
+
+        float cost;
+        uint32_t parent;
+        // Null for board openings that are only a link in the chain and never queued
+        const SearchKey *state;
+        PlanStep step;
+    };
 
-    struct State
+    // Ordered by cost so far, plus the estimate of what is left in A* mode
+    struct QueueEntry
     {
         float cost;
-        float length;
-        Record operations;
-        CutList cuts;
+        uint32_t node;
+    };
 
-        operator EndState()
+    struct QueueEntryCompare
+    {
+        bool operator()(const QueueEntry &a, const QueueEntry &b) const
         {
-            EndState new_self;
-            new_self.cost = this->cost;
-            new_self.operations = this->operations;
-            return new_self;
-        };
+            if (a.cost != b.cost)
+            {
+                return b.cost < a.cost;
+            }
+            // Among equal costs prefer the newest node, it is the deepest one
+            return a.node < b.node;
+        }
     };
 
-    struct StateCompare
+    class BinaryHeapOpenList
     {
-        bool operator()(const State &a, const State &b) const
+    public:
+        static constexpr size_t entry_bytes = sizeof(QueueEntry);
+
+        void push(const QueueEntry &entry)
+        {
+            queue.push(entry);
+        }
+
+        const QueueEntry &top()
+        {
+            return queue.top();
+        }
+
+        void pop()
+        {
+            queue.pop();
+        }
+
+        bool empty() const
+        {
+            return queue.empty();
+        }
+
+        size_t size() const
         {
-            return b.cost < a.cost;
+            return queue.size();
         }
+
+    private:
+        std::priority_queue<QueueEntry, std::vector<QueueEntry>, QueueEntryCompare> queue;
     };
 
-    class CutSolver
+    // A* with a consistent estimate never pushes a bound below the last one popped, so an
+    // entry only has to sit in the bucket of the highest bit where its bound differs from
+    // that one, and only the lowest bucket in use is ever split. Non-negative floats order
+    // like their bits. A bucket keeps its entries in push order, so among equal bounds the
+    // newest node pops first and the order is exactly that of the binary heap.
+    class RadixHeapOpenList
     {
     public:
-        CutSolver(std::vector<Source> &sources_) : sources(sources_) {};
+        static constexpr size_t entry_bytes = sizeof(uint32_t) + sizeof(QueueEntry);
 
-        EndState solve(CutList &cut_list)
+        void push(const QueueEntry &entry)
         {
-            State start_state;
-            start_state.cost = 0;
-            start_state.length = 0;
-            start_state.cuts = cut_list;
-            start_state.operations = {};
+            // Float rounding can leave a child an ulp under its parent, it is still popped next
+            const uint32_t key = std::max(std::bit_cast<uint32_t>(entry.cost), last);
+            buckets[bucket(key)].push_back(Item{key, entry});
+            count++;
+        }
 
-            std::priority_queue<State, std::vector<State>, StateCompare> queue;
-            queue.emplace(start_state);
+        const QueueEntry &top()
+        {
+            settle();
+            return buckets[0].back().entry;
+        }
 
-            while (true)
-            {
-                State state = queue.top();
-                queue.pop();
+        void pop()
+        {
+            settle();
+            buckets[0].pop_back();
+            count--;
+        }
 
-                if (state.cuts.size() == 0)
-                {
-                    return state;
-                }
+        bool empty() const
+        {
+            return count == 0;
+        }
 
-                if (state.length < cut_list[0].length)
-                {
-                    state.length = 0;
-                    for (const auto &source : sources)
-                    {
-                        State cpy = state;
-                        cpy.length += source.length;
-                        cpy.cost += source.cost;
-                        cpy.operations.push(source);
-                        queue.emplace(cpy);
-                    }
-                }
-                else
-                {
-                    for (size_t i = 0; i < state.cuts.size(); i++)
-                    {
-                        if (state.cuts[i].length <= state.length && state.cuts[i].quantity != 0)
-                        {
-                            State cpy = state;
-                            cpy.length -= state.cuts[i].length;
-                            cpy.cuts[i].quantity -= 1;
-                            if (cpy.cuts[i].quantity == 0)
-                            {
-                                cpy.cuts.erase(cpy.cuts.begin() + i);
-                            }
+        size_t size() const
+        {
+            return count;
+        }
 
-                            cpy.operations.push(state.cuts[i]);
-                            queue.emplace(cpy);
-                        }
-                    }
-                }
+    private:
+        struct Item
+        {
+            uint32_t key;
+            QueueEntry entry;
+        };
+
+        size_t bucket(uint32_t key) const
+        {
+            return key == last ? 0 : 32 - std::countl_zero(key ^ last);
+        }
+
+        // Refills the bucket of the last key from the lowest bucket in use
+        void settle()
+        {
+            if (!buckets[0].empty())
+            {
+                return;
+            }
+
+            size_t i = 1;
+            while (buckets[i].empty())
+            {
+                i++;
             }
+            last = std::min_element(buckets[i].begin(), buckets[i].end(), [](const Item &a, const Item &b)
+                                    { return a.key < b.key; })
+                       ->key;
+            for (const Item &item : buckets[i])
+            {
+                buckets[bucket(item.key)].push_back(item);
+            }
+            buckets[i].clear();
         }
 
-    private:
-        const std::vector<Source> &sources;
+        std::array<std::vector<Item>, 33> buckets;
+        uint32_t last = 0;
+        size_t count = 0;
     };
-}
 
-EndState solve_cut_problem(std::vector<Source> &sources, std::vector<Cut> &cuts)
-{
-    std::sort(cuts.begin(), cuts.end(), CutLengthSorter());
-    std::sort(sources.begin(), sources.end(), SourceLengthSorter());
-    CutSolver solver(sources);
-    return solver.solve(cuts);
-}
+    constexpr bool collect_stats = CUTLIST_SOLVER_STATS;
 
-namespace
-{
-    struct CutBlock
+    // Memory of one single-threaded solve. States and table entries are taken from pools
+    // that hand what duplicates and finished levels free to the next ones, and the pools
+    // carve their chunks out of an arena that is returned whole when the solver goes.
+    // No lock is taken, so solves running side by side never wait on each other's allocations.
+    struct SolveArena
     {
-        std::string source_name;
-        float source_length;
-        std::vector<float> cut_lengths;
+        std::pmr::monotonic_buffer_resource chunks;
+        std::pmr::unsynchronized_pool_resource pool{&chunks};
     };
 
-};
-
-namespace std
-{
-    template <>
-    struct hash<CutBlock>
+    // Adds the time until it goes out of scope to one phase of the stats
+    class PhaseTimer
     {
-        size_t operator()(const CutBlock &block) const
+    public:
+        PhaseTimer(SolverStats *stats_, double SolverStats::*phase_)
+            : stats(collect_stats ? stats_ : nullptr), phase(phase_)
         {
-            size_t a = 98230981;
-            hash_combine(a, block.source_name);
-            hash_combine(a, block.source_length);
-            for (size_t i = 0; i < block.cut_lengths.size(); i++)
+            if (stats)
             {
-                hash_combine(a, block.cut_lengths[i]);
+                began = std::chrono::steady_clock::now();
             }
-            return a;
         }
-    };
 
-    template <>
-    struct equal_to<CutBlock>
-    {
-        bool operator()(const CutBlock &a, const CutBlock &b) const
+        ~PhaseTimer()
         {
-            if (a.source_length != b.source_length || a.cut_lengths.size() != b.cut_lengths.size() || b.source_name != a.source_name)
+            if (stats)
             {
-                return false;
+                stats->*phase += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - began).count();
             }
-            for (size_t i = 0; i < a.cut_lengths.size(); i++)
+        }
+
+    private:
+        SolverStats *const stats;
+        double SolverStats::*const phase;
+        std::chrono::steady_clock::time_point began;
+    };
+
+    // How a search state is bounded and how cuts go on the current board,
+    // shared by the serial and the parallel search
+    class SearchRules
+    {
+    public:
+        SearchRules(const std::vector<Source> &sources_, const SolverOptions &options_, float root_bound_)
+            : sources(sources_), options(options_), start(std::chrono::steady_clock::now()), root_bound(root_bound_)
+        {
+            cost_per_length = std::numeric_limits<float>::infinity();
+            for (const auto &source : sources)
             {
-                if (a.cut_lengths[i] != b.cut_lengths[i])
+                if (source.length > 0)
                 {
-                    return false;
+                    cost_per_length = std::min(cost_per_length, source.cost / static_cast<float>(source.length));
                 }
             }
-            return true;
         }
-    };
-}
 
-void output(std::ostream &out, const Problem &problem, const EndState &solution)
-{
-    const auto vec = solution.operations.c;
+    protected:
+        static constexpr size_t clock_interval = 64;
 
-    std::reference_wrapper<const Source> curr_src = std::get<Source>(vec[0]);
+        // A node is worth searching when its bound is under the incumbent by more than the gap
+        bool can_improve(float bound, float incumbent) const
+        {
+            return bound < incumbent * (1 - options.gap);
+        }
 
-    CutBlock curr_block;
+        // The best lower bound known on the optimum: the LP bound of the whole problem or
+        // the least bound of what the search has not ruled out, never above the incumbent
+        float proven_bound(float unexplored, float incumbent) const
+        {
+            return std::min(incumbent, std::max(root_bound, unexplored));
+        }
 
-    curr_block.source_length = curr_src.get().length;
-    curr_block.source_name = problem.source_names.find(curr_src.get())->second;
+        // Remembers the cut lengths of the root list, which cut steps index
+        void index_cuts(const CutList &cuts)
+        {
+            if (sources.size() > source_step || cuts.size() > source_step)
+            {
+                throw std::length_error("Cut solver has more distinct sources or cuts than a plan step can index");
+            }
+            root_cuts = cuts;
+        }
 
-    std::unordered_map<CutBlock, size_t> block_count;
+        PlanStep encode(const Source &source) const
+        {
+            return static_cast<PlanStep>(source_step | (&source - sources.data()));
+        }
 
-    for (size_t i = 1; i < vec.size(); i++)
-    {
-        if (vec[i].index() == 0) // Cut
+        PlanStep encode(const Cut &cut) const
         {
-            curr_block.cut_lengths.emplace_back(std::get<Cut>(vec[i]).length);
+            const auto it = std::lower_bound(root_cuts.begin(), root_cuts.end(), cut, CutLengthSorter());
+            return static_cast<PlanStep>(it - root_cuts.begin());
         }
-        else
+
+        Operation decode(PlanStep step) const
         {
-            // Increment count for the block
-            auto it = block_count.find(curr_block);
-            if (it == block_count.end())
+            if (step & source_step)
             {
-                block_count[curr_block] = 1;
+                return sources[step & ~source_step];
             }
-            else
+            return root_cuts[step];
+        }
+
+        Record decode(const std::vector<PlanStep> &steps) const
+        {
+            Record record;
+            for (PlanStep step : steps)
             {
-                it->second++;
+                record.push(decode(step));
             }
+            return record;
+        }
 
-            // Set block to new source
-            curr_src = std::get<Source>(vec[i]);
-            curr_block.source_length = curr_src.get().length;
-            curr_block.source_name = problem.source_names.find(curr_src.get())->second;
-            curr_block.cut_lengths.clear();
+        // Bytes one interned state takes, counting a cut list as long as the root's
+        static size_t state_bytes(size_t cut_count)
+        {
+            return sizeof(SearchKey) + sizeof(float) + 4 * sizeof(void *) + cut_count * sizeof(Cut);
         }
-    }
 
-    // Increment count for the last block because there is no source to end it on
-    auto it = block_count.find(curr_block);
-    if (it == block_count.end())
-    {
-        block_count[curr_block] = 1;
-    }
-    else
-    {
-        it->second++;
-    }
+        bool over_budget(size_t expanded, size_t bytes) const
+        {
+            if (options.node_limit != 0 && expanded >= options.node_limit)
+            {
+                return true;
+            }
+            if (options.memory_limit != 0 && bytes >= options.memory_limit)
+            {
+                return true;
+            }
+            if (expanded % clock_interval != 0)
+            {
+                return false;
+            }
+            if (options.cancel && options.cancel->load(std::memory_order_relaxed))
+            {
+                return true;
+            }
+            return options.time_limit.count() != 0 && std::chrono::steady_clock::now() - start >= options.time_limit;
+        }
+
+        // Stats hooks, compiled out when CUTLIST_SOLVER_STATS is 0
+        void count_expansion() const
+        {
+            if constexpr (collect_stats)
+            {
+                if (options.stats)
+                {
+                    options.stats->nodes_expanded++;
+                }
+            }
+        }
 
-    out << "For: " << problem.tag << ", Cost: " << solution.cost << '\n';
+        void count_generated() const
+        {
+            if constexpr (collect_stats)
+            {
+                if (options.stats)
+                {
+                    options.stats->nodes_generated++;
+                }
+            }
+        }
 
-    std::vector<std::pair<CutBlock, size_t>> items{block_count.begin(), block_count.end()};
+        void count_duplicate() const
+        {
+            if constexpr (collect_stats)
+            {
+                if (options.stats)
+                {
+                    options.stats->duplicates_pruned++;
+                }
+            }
+        }
 
-    std::sort(items.begin(), items.end(),[](const std::pair<CutBlock, size_t>& a, const std::pair<CutBlock, size_t>& b){
-        return a.first.source_length < b.first.source_length;
-    });
+        void track_queue(size_t size, size_t entry_bytes) const
+        {
+            if constexpr (collect_stats)
+            {
+                if (options.stats && size > options.stats->peak_queue_size)
+                {
+                    options.stats->peak_queue_size = size;
+                    options.stats->peak_queue_bytes = size * entry_bytes;
+                }
+            }
+        }
 
-    for (const auto &item : items)
-    {
-        out << "\t(" << item.second << "x) [" << item.first.source_name << ", " << item.first.source_length << "] -> [";
-        for (size_t i = 0; i < item.first.cut_lengths.size(); i++)
+        // Lower bound on the cost still to pay: whatever the offcut cannot cover has to be
+        // bought at the best price per length. Placing a cut leaves it unchanged and opening
+        // a board lowers it by at most that board's cost, so it is consistent and the first
+        // finished plan popped is still the cheapest.
+        float estimate(const SearchKey &state) const
         {
-            out << item.first.cut_lengths[i];
-            if (i != item.first.cut_lengths.size() - 1)
+            if (!options.a_star)
+            {
+                return 0;
+            }
+
+            int64_t length = -state.length;
+            for (const auto &cut : state.cuts)
             {
-                out << ", ";
+                length += static_cast<int64_t>(cut.length) * cut.quantity;
             }
+            return length > 0 ? static_cast<float>(length) * cost_per_length : 0;
         }
-        out << "]\n";
-    }
-}
\ No newline at end of file
+
+        static bool fits_any(const SearchKey &state)
+        {
+            return state.cuts.size() != 0 && state.cuts[0].length <= std::min(state.length, state.cap);
+        }
+
+        SearchKey place_cut(const SearchKey &state, size_t i) const
+        {
+            SearchKey child = state;
+            child.length -= state.cuts[i].length;
+            if (options.canonical_ordering)
+            {
+                // Cuts on a board are placed longest first
+                child.cap = state.cuts[i].length;
+            }
+            child.cuts[i].quantity -= 1;
+            if (child.cuts[i].quantity == 0)
+            {
+                child.cuts.erase(child.cuts.begin() + i);
+            }
+
+            if (!fits_any(child))
+            {
+                child.length = 0;
+                child.cap = 0;
+            }
+            return child;
+        }
+
+        // Places the longest cut that still fits until the board is full, returns the length placed
+        Length fill_board(SearchKey &state, std::vector<PlanStep> *steps) const
+        {
+            Length placed = 0;
+            for (size_t i = state.cuts.size(); i-- > 0 && fits_any(state);)
+            {
+                while (i < state.cuts.size() && state.cuts[i].length <= std::min(state.length, state.cap))
+                {
+                    placed += state.cuts[i].length;
+                    if (steps)
+                    {
+                        steps->push_back(encode(state.cuts[i]));
+                    }
+                    state = place_cut(state, i);
+                }
+            }
+            return placed;
+        }
+
+        // First-fit-decreasing without branching: the current board is filled, then every new
+        // board is the source that costs least per length placed when filled the same way.
+        // Returns the cost added, and appends the steps taken when asked to.
+        float complete_greedily(SearchKey state, std::vector<PlanStep> *steps) const
+        {
+            float cost = 0;
+            fill_board(state, steps);
+            while (state.cuts.size() != 0)
+            {
+                const Source *best = nullptr;
+                float best_rate = std::numeric_limits<float>::infinity();
+                for (const auto &source : sources)
+                {
+                    if (source.length < state.cuts.back().length)
+                    {
+                        continue;
+                    }
+                    SearchKey trial{state.cuts, source.length, source.length};
+                    const Length placed = fill_board(trial, nullptr);
+                    const float rate = placed > 0 ? source.cost / static_cast<float>(placed) : source.cost;
+                    if (rate < best_rate)
+                    {
+                        best = &source;
+                        best_rate = rate;
+                    }
+                }
+                if (best == nullptr)
+                {
+                    throw std::runtime_error("There is a cut that is longer than the longest source");
+                }
+
+                cost += best->cost;
+                if (steps)
+                {
+                    steps->push_back(encode(*best));
+                }
+                state.length = best->length;
+                state.cap = best->length;
+                fill_board(state, steps);
+            }
+            return cost;
+        }
+
+        struct Step
+        {
+            SearchKey state;
+            float cost;
+            float bound;
+            std::array<PlanStep, 2> steps;
+            size_t step_count;
+        };
+
+        // Every move out of a state with its bound, most promising first
+        std::vector<Step> branch(const SearchKey &state, float cost) const
+        {
+            std::vector<Step> steps;
+            if (fits_any(state))
+            {
+                for (size_t i = 0; i < state.cuts.size(); i++)
+                {
+                    if (state.cuts[i].length <= std::min(state.length, state.cap))
+                    {
+                        steps.push_back(Step{place_cut(state, i), cost, 0, {encode(state.cuts[i])}, 1});
+                    }
+                }
+            }
+            else if (options.canonical_ordering)
+            {
+                const size_t longest = state.cuts.size() - 1;
+                for (const auto &source : sources)
+                {
+                    if (source.length < state.cuts[longest].length)
+                    {
+                        continue;
+                    }
+                    SearchKey opened{state.cuts, source.length, source.length};
+                    steps.push_back(Step{place_cut(opened, longest), cost + source.cost, 0, {encode(source), encode(state.cuts[longest])}, 2});
+                }
+            }
+            else
+            {
+                for (const auto &source : sources)
+                {
+                    if (source.length < state.cuts[0].length)
+                    {
+                        continue;
+                    }
+                    constexpr Length unbounded = std::numeric_limits<Length>::max();
+                    steps.push_back(Step{SearchKey{state.cuts, source.length, unbounded}, cost + source.cost, 0, {encode(source)}, 1});
+                }
+            }
+
+            for (auto &step : steps)
+            {
+                step.bound = step.cost + estimate(step.state);
+            }
+            std::sort(steps.begin(), steps.end(), [](const Step &a, const Step &b)
+                      { return a.bound < b.bound; });
+            return steps;
+        }
+
+        const std::vector<Source> &sources;
+        const SolverOptions &options;
+        const std::chrono::steady_clock::time_point start;
+        // LP relaxation of the whole problem when a gap is accepted, 0 otherwise
+        const float root_bound;
+        float cost_per_length;
+        CutList root_cuts;
+    };
+
+    template <typename Queue>
+    class CutSolver : private SearchRules
+    {
+    public:
+        CutSolver(std::vector<Source> &sources_, const SolverOptions &options_, float root_bound_)
+            : SearchRules(sources_, options_, root_bound_) {};
+
+        EndState solve(CutList &cut_list)
+        {
+            nodes.clear();
+            best_cost.clear();
+            index_cuts(cut_list);
+            pruned_bound = std::numeric_limits<float>::infinity();
+
+            const auto root = best_cost.emplace(SearchKey(cut_list, &arena.pool), 0.0f).first;
+            nodes.push_back(Node{0, Node::no_parent, &root->first, 0});
+
+            // Start from the greedy plan, so there is an answer however soon the budget runs out
+            incumbent.cost = std::numeric_limits<float>::infinity();
+            try_greedy(0);
+            if (options.warm_start && options.warm_start->cost < incumbent.cost)
+            {
+                incumbent = *options.warm_start;
+            }
+
+            Queue queue;
+            queue.push(QueueEntry{0, 0});
+
+            for (size_t expanded = 0; !queue.empty(); expanded++)
+            {
+                // Nothing cheaper than the best bound still queued or dropped within the gap can exist
+                const float unexplored = std::min(queue.top().cost, pruned_bound);
+                if (!can_improve(std::max(root_bound, unexplored), incumbent.cost) ||
+                    over_budget(expanded, memory_used(queue.size())))
+                {
+                    incumbent.lower_bound = proven_bound(unexplored, incumbent.cost);
+                    return incumbent;
+                }
+
+                const uint32_t index = queue.top().node;
+                queue.pop();
+
+                const Node node = nodes[index];
+                const SearchKey &state = *node.state;
+
+                // A cheaper path to this state was found after the node was queued
+                if (node.cost > best_cost.find(state)->second)
+                {
+                    continue;
+                }
+
+                if (state.cuts.size() == 0)
+                {
+                    incumbent = reconstruct(index);
+                    incumbent.lower_bound = proven_bound(pruned_bound, incumbent.cost);
+                    report();
+                    return incumbent;
+                }
+
+                count_expansion();
+                if (expanded % rollout_interval == rollout_interval - 1)
+                {
+                    try_greedy(index);
+                }
+
+                if (fits_any(state))
+                {
+                    for (size_t i = 0; i < state.cuts.size(); i++)
+                    {
+                        if (state.cuts[i].length <= std::min(state.length, state.cap))
+                        {
+                            push_child(queue, index, node.cost, place_cut(state, i), encode(state.cuts[i]));
+                        }
+                    }
+                }
+                else if (options.canonical_ordering)
+                {
+                    // Boards are opened longest piece first, so the next board starts
+                    // with the longest cut left and only sources that hold it are tried
+                    const size_t longest = state.cuts.size() - 1;
+                    for (const auto &source : sources)
+                    {
+                        if (source.length < state.cuts[longest].length)
+                        {
+                            continue;
+                        }
+                        SearchKey opened{state.cuts, source.length, source.length};
+                        const uint32_t link = add_node(node.cost + source.cost, index, encode(source), nullptr);
+                        push_child(queue, link, node.cost + source.cost, place_cut(opened, longest), encode(state.cuts[longest]));
+                    }
+                }
+                else
+                {
+                    for (const auto &source : sources)
+                    {
+                        // Skip boards that could not take any of the remaining cuts
+                        if (source.length < state.cuts[0].length)
+                        {
+                            continue;
+                        }
+                        constexpr Length unbounded = std::numeric_limits<Length>::max();
+                        push_child(queue, index, node.cost + source.cost, SearchKey{state.cuts, source.length, unbounded}, encode(source));
+                    }
+                }
+            }
+
+            // Everything left could not beat the incumbent
+            incumbent.lower_bound = proven_bound(pruned_bound, incumbent.cost);
+            return incumbent;
+        }
+
+    private:
+        size_t memory_used(size_t queued) const
+        {
+            return nodes.size() * sizeof(Node) + queued * Queue::entry_bytes +
+                   best_cost.size() * state_bytes(nodes[0].state->cuts.size());
+        }
+
+        // How often the node just popped is finished greedily in search of a better incumbent
+        static constexpr size_t rollout_interval = 256;
+
+        void try_greedy(uint32_t index)
+        {
+            const Node &node = nodes[index];
+            if (node.cost + complete_greedily(*node.state, nullptr) >= incumbent.cost)
+            {
+                return;
+            }
+
+            std::vector<PlanStep> rest;
+            const float cost = node.cost + complete_greedily(*node.state, &rest);
+            incumbent = reconstruct(index);
+            incumbent.cost = cost;
+            for (PlanStep step : rest)
+            {
+                incumbent.operations.push(decode(step));
+            }
+            report();
+        }
+
+        void report() const
+        {
+            if (options.on_incumbent)
+            {
+                options.on_incumbent(incumbent);
+            }
+        }
+
+        uint32_t add_node(float cost, uint32_t parent, PlanStep step, const SearchKey *state)
+        {
+            if (nodes.size() >= Node::no_parent)
+            {
+                throw std::length_error("Cut solver exceeded its node limit");
+            }
+            nodes.push_back(Node{cost, parent, state, step});
+            return static_cast<uint32_t>(nodes.size() - 1);
+        }
+
+        void push_child(Queue &queue, uint32_t parent, float cost, SearchKey &&key, PlanStep step)
+        {
+            count_generated();
+            const float bound = cost + estimate(key);
+            if (!can_improve(bound, incumbent.cost))
+            {
+                pruned_bound = std::min(pruned_bound, bound);
+                return;
+            }
+
+            auto [it, inserted] = best_cost.try_emplace(std::move(key), cost);
+            if (!inserted)
+            {
+                if (it->second <= cost)
+                {
+                    count_duplicate();
+                    return;
+                }
+                it->second = cost;
+            }
+
+            queue.push(QueueEntry{bound, add_node(cost, parent, step, &it->first)});
+            track_queue(queue.size(), Queue::entry_bytes);
+        }
+
+        EndState reconstruct(uint32_t index) const
+        {
+            PhaseTimer timer(options.stats, &SolverStats::reconstruction_ms);
+            EndState end_state;
+            end_state.cost = nodes[index].cost;
+
+            std::vector<uint32_t> path;
+            for (uint32_t i = index; nodes[i].parent != Node::no_parent; i = nodes[i].parent)
+            {
+                path.push_back(i);
+            }
+
+            for (auto it = path.rbegin(); it != path.rend(); ++it)
+            {
+                end_state.operations.push(decode(nodes[*it].step));
+            }
+            return end_state;
+        }
+
+        EndState incumbent;
+        // Least bound of the nodes dropped because they could not beat the incumbent by the gap
+        float pruned_bound;
+        std::vector<Node> nodes;
+        SolveArena arena;
+        // Transposition table: cheapest cost each state has been reached at.
+        // Nodes point at its keys, unordered_map keeps them in place on rehash.
+        std::pmr::unordered_map<SearchKey, float> best_cost{&arena.pool};
+    };
+
+    struct SearchKeyHashCompare
+    {
+        static size_t hash(const SearchKey &key)
+        {
+            return std::hash<SearchKey>{}(key);
+        }
+
+        static bool equal(const SearchKey &a, const SearchKey &b)
+        {
+            return std::equal_to<SearchKey>{}(a, b);
+        }
+    };
+
+    // Depth-first branch-and-bound spread over TBB workers. The children of shallow nodes
+    // are handed to tbb::parallel_for_each, so idle workers steal untried siblings of busy
+    // ones. All workers share the cheapest plan found so far and drop every node whose
+    // bound cannot beat it, so the plan left at the end is optimal unless the budget ran out.
+    class ParallelCutSolver : private SearchRules
+    {
+    public:
+        ParallelCutSolver(std::vector<Source> &sources_, const SolverOptions &options_, float root_bound_, EndState &&incumbent_)
+            : SearchRules(sources_, options_, root_bound_), incumbent(std::move(incumbent_)), best(incumbent.cost) {};
+
+        EndState solve(CutList &cut_list)
+        {
+            index_cuts(cut_list);
+            const SearchKey root(cut_list, &pool);
+            std::vector<PlanStep> path;
+            auto run = [&]()
+            { expand(root, 0, path, 0); };
+
+            if (!can_improve(root_bound, incumbent.cost))
+            {
+                // The starting plan is already within the gap
+            }
+            else if (options.threads == 0)
+            {
+                run();
+            }
+            else
+            {
+                tbb::task_arena arena(static_cast<int>(options.threads));
+                arena.execute(run);
+            }
+            if (stopped.load(std::memory_order_relaxed))
+            {
+                // Any subtree may have been left unsearched, only the root's estimate still holds
+                incumbent.lower_bound = proven_bound(estimate(root), incumbent.cost);
+            }
+            else
+            {
+                // Every node dropped was bounded by the gap below an incumbent at least as costly as the last one
+                incumbent.lower_bound = proven_bound(incumbent.cost * (1 - options.gap), incumbent.cost);
+            }
+            return incumbent;
+        }
+
+    private:
+        // Below this depth the children of a node are searched by the worker that made them
+        static constexpr size_t spawn_depth = 12;
+
+        void expand(const SearchKey &state, float cost, std::vector<PlanStep> &path, size_t depth)
+        {
+            if (state.cuts.size() == 0)
+            {
+                improve(cost, path);
+                return;
+            }
+
+            // The workers count expansions together, once one finds the budget spent they all unwind
+            if (stopped.load(std::memory_order_relaxed) ||
+                over_budget(expanded.fetch_add(1, std::memory_order_relaxed), best_cost.size() * state_bytes(root_cuts.size())))
+            {
+                stopped.store(true, std::memory_order_relaxed);
+                return;
+            }
+
+            std::vector<Step> steps = branch(state, cost);
+            if (depth < spawn_depth)
+            {
+                tbb::parallel_for_each(steps.begin(), steps.end(), [&](const Step &step)
+                                       {
+                                           if (!admit(step))
+                                           {
+                                               return;
+                                           }
+                                           std::vector<PlanStep> branch_path = path;
+                                           branch_path.insert(branch_path.end(), step.steps.begin(), step.steps.begin() + step.step_count);
+                                           expand(step.state, step.cost, branch_path, depth + 1); });
+                return;
+            }
+
+            for (const auto &step : steps)
+            {
+                if (!admit(step))
+                {
+                    continue;
+                }
+                path.insert(path.end(), step.steps.begin(), step.steps.begin() + step.step_count);
+                expand(step.state, step.cost, path, depth + 1);
+                path.resize(path.size() - step.step_count);
+            }
+        }
+
+        // A step is searched when it can still beat the incumbent and no worker
+        // has reached its state at the same cost or cheaper
+        bool admit(const Step &step)
+        {
+            if (!can_improve(step.bound, best.load(std::memory_order_relaxed)))
+            {
+                return false;
+            }
+
+            tbb::concurrent_hash_map<SearchKey, float, SearchKeyHashCompare>::accessor accessor;
+            if (!best_cost.insert(accessor, step.state))
+            {
+                if (accessor->second <= step.cost)
+                {
+                    return false;
+                }
+            }
+            accessor->second = step.cost;
+            return true;
+        }
+
+        void improve(float cost, const std::vector<PlanStep> &path)
+        {
+            std::lock_guard<std::mutex> lock(incumbent_mutex);
+            if (cost >= incumbent.cost)
+            {
+                return;
+            }
+            incumbent.cost = cost;
+            incumbent.operations = decode(path);
+            best.store(cost, std::memory_order_relaxed);
+        }
+
+        std::mutex incumbent_mutex;
+        EndState incumbent;
+        // Cost of the incumbent, read by every worker without taking the lock
+        std::atomic<float> best;
+        std::atomic<size_t> expanded{0};
+        std::atomic<bool> stopped{false};
+        // The workers share one solve, so its states come from a pool that takes a lock
+        std::pmr::synchronized_pool_resource pool;
+        tbb::concurrent_hash_map<SearchKey, float, SearchKeyHashCompare> best_cost;
+    };
+
+    // Iterative deepening on the A* bound. Each pass is a depth-first branch-and-bound that
+    // skips nodes whose bound is over the threshold, which then rises to the lowest bound
+    // skipped. Memory is the current path plus a transposition table that stops taking new
+    // states once memory_limit is reached.
+    class IterativeDeepeningCutSolver : private SearchRules
+    {
+    public:
+        IterativeDeepeningCutSolver(std::vector<Source> &sources_, const SolverOptions &options_, float root_bound_)
+            : SearchRules(sources_, options_, root_bound_) {};
+
+        EndState solve(CutList &cut_list)
+        {
+            index_cuts(cut_list);
+            const SearchKey root(cut_list, &arena.pool);
+            std::vector<PlanStep> greedy;
+            improve(complete_greedily(root, &greedy), greedy);
+
+            float threshold = estimate(root);
+            while (can_improve(std::max(root_bound, std::min(threshold, pruned_bound)), incumbent.cost))
+            {
+                next_threshold = std::numeric_limits<float>::infinity();
+                best_cost.clear();
+                path.clear();
+                if (!search(root, 0, threshold))
+                {
+                    // The budget ran out in this pass, the passes before it covered every plan cheaper than the threshold
+                    break;
+                }
+                threshold = next_threshold;
+            }
+
+            incumbent.lower_bound = proven_bound(std::min(threshold, pruned_bound), incumbent.cost);
+            return incumbent;
+        }
+
+    private:
+        // False once the budget runs out. memory_limit only caps the transposition table, in admit.
+        bool search(const SearchKey &state, float cost, float threshold)
+        {
+            if (over_budget(expanded++, 0))
+            {
+                return false;
+            }
+
+            if (state.cuts.size() == 0)
+            {
+                improve(cost, path);
+                return true;
+            }
+
+            count_expansion();
+            for (const auto &step : branch(state, cost))
+            {
+                count_generated();
+                if (!can_improve(step.bound, incumbent.cost))
+                {
+                    pruned_bound = std::min(pruned_bound, step.bound);
+                    break;
+                }
+                if (step.bound > threshold)
+                {
+                    next_threshold = std::min(next_threshold, step.bound);
+                    break;
+                }
+                if (!admit(step))
+                {
+                    continue;
+                }
+
+                path.insert(path.end(), step.steps.begin(), step.steps.begin() + step.step_count);
+                if (!search(step.state, step.cost, threshold))
+                {
+                    return false;
+                }
+                path.resize(path.size() - step.step_count);
+            }
+            return true;
+        }
+
+        bool admit(const Step &step)
+        {
+            const auto it = best_cost.find(step.state);
+            if (it != best_cost.end())
+            {
+                if (it->second <= step.cost)
+                {
+                    count_duplicate();
+                    return false;
+                }
+                it->second = step.cost;
+            }
+            else if (options.memory_limit == 0 || (best_cost.size() + 1) * state_bytes(step.state.cuts.size()) < options.memory_limit)
+            {
+                best_cost.emplace(step.state, step.cost);
+            }
+            return true;
+        }
+
+        void improve(float cost, const std::vector<PlanStep> &steps)
+        {
+            if (cost >= incumbent.cost)
+            {
+                return;
+            }
+            incumbent.cost = cost;
+            incumbent.operations = decode(steps);
+            if (options.on_incumbent)
+            {
+                options.on_incumbent(incumbent);
+            }
+        }
+
+        EndState incumbent{std::numeric_limits<float>::infinity(), 0, {}};
+        float next_threshold;
+        // Least bound of the steps dropped because they could not beat the incumbent by the gap
+        float pruned_bound = std::numeric_limits<float>::infinity();
+        size_t expanded = 0;
+        std::vector<PlanStep> path;
+        SolveArena arena;
+        std::pmr::unordered_map<SearchKey, float> best_cost{&arena.pool};
+    };
+
+    // Breadth-first over moves, keeping only the beam_width children with the lowest bound
+    // at each depth. Memory and time are bounded by the width, the plan is not proven optimal.
+    class BeamCutSolver : private SearchRules
+    {
+    public:
+        BeamCutSolver(std::vector<Source> &sources_, const SolverOptions &options_) : SearchRules(sources_, options_, 0) {};
+
+        EndState solve(CutList &cut_list)
+        {
+            index_cuts(cut_list);
+            const SearchKey root(cut_list, &arena.pool);
+            std::vector<PlanStep> greedy;
+            EndState incumbent{complete_greedily(root, &greedy), 0, {}};
+            incumbent.operations = decode(greedy);
+
+            const size_t width = beam_width(root);
+            std::vector<BeamNode> beam{BeamNode{root, 0, estimate(root), no_trail, {}, 0}};
+            std::vector<BeamNode> children;
+            std::pmr::unordered_map<SearchKey, size_t> child_index{&arena.pool};
+
+            while (!beam.empty())
+            {
+                children.clear();
+                child_index.clear();
+                for (const auto &node : beam)
+                {
+                    count_expansion();
+                    for (auto &step : branch(node.state, node.cost))
+                    {
+                        count_generated();
+                        if (step.bound >= incumbent.cost)
+                        {
+                            break;
+                        }
+
+                        // A finished plan only replaces the incumbent, it is never a child
+                        if (step.state.cuts.size() == 0)
+                        {
+                            incumbent.cost = step.cost;
+                            incumbent.operations = replay(extend(node.trail, step.steps, step.step_count));
+                            if (options.on_incumbent)
+                            {
+                                options.on_incumbent(incumbent);
+                            }
+                            continue;
+                        }
+
+                        const auto [it, inserted] = child_index.try_emplace(step.state, children.size());
+                        if (!inserted && children[it->second].cost <= step.cost)
+                        {
+                            count_duplicate();
+                            continue;
+                        }
+
+                        // The moves are only added to the trails once the child survives the cut
+                        BeamNode child{std::move(step.state), step.cost, step.bound, node.trail, step.steps, step.step_count};
+                        if (inserted)
+                        {
+                            children.push_back(std::move(child));
+                        }
+                        else
+                        {
+                            children[it->second] = std::move(child);
+                        }
+                    }
+                }
+
+                track_queue(children.size(), sizeof(BeamNode));
+                if (children.size() > width)
+                {
+                    std::nth_element(children.begin(), children.begin() + width, children.end(),
+                                     [](const BeamNode &a, const BeamNode &b)
+                                     { return a.bound < b.bound; });
+                    children.erase(children.begin() + width, children.end());
+                }
+                for (auto &child : children)
+                {
+                    child.trail = extend(child.trail, child.steps, child.step_count);
+                    child.step_count = 0;
+                }
+                std::swap(beam, children);
+
+                // The trails outlive every layer, once they fill the budget the incumbent stands
+                if (options.memory_limit != 0 && trails.size() * sizeof(Trail) >= options.memory_limit)
+                {
+                    break;
+                }
+            }
+
+            incumbent.lower_bound = std::min(incumbent.cost, estimate(root));
+            return incumbent;
+        }
+
+    private:
+        static constexpr uint32_t no_trail = std::numeric_limits<uint32_t>::max();
+
+        // A state of the layer being built, with the moves that reached it from its parent's trail
+        struct BeamNode
+        {
+            SearchKey state;
+            float cost;
+            float bound;
+            uint32_t trail;
+            std::array<PlanStep, 2> steps;
+            size_t step_count;
+        };
+
+        // The moves of every beam node, each linked to the one before it
+        struct Trail
+        {
+            uint32_t parent;
+            PlanStep step;
+        };
+
+        // beam_width, narrowed so a whole layer fits memory_limit before the cut:
+        // every node can branch once per cut left or per source, and the layer
+        // before it is still held
+        size_t beam_width(const SearchKey &root) const
+        {
+            if (options.memory_limit == 0)
+            {
+                return options.beam_width;
+            }
+            const size_t node_bytes = sizeof(BeamNode) + state_bytes(root.cuts.size());
+            const size_t fanout = std::max(root.cuts.size(), sources.size()) + 1;
+            return std::min(options.beam_width, std::max<size_t>(options.memory_limit / (node_bytes * fanout), 1));
+        }
+
+        uint32_t extend(uint32_t trail, const std::array<PlanStep, 2> &steps, size_t step_count)
+        {
+            for (size_t i = 0; i < step_count; i++)
+            {
+                trails.push_back(Trail{trail, steps[i]});
+                trail = static_cast<uint32_t>(trails.size() - 1);
+            }
+            return trail;
+        }
+
+        Record replay(uint32_t trail) const
+        {
+            PhaseTimer timer(options.stats, &SolverStats::reconstruction_ms);
+            std::vector<PlanStep> steps;
+            for (uint32_t i = trail; i != no_trail; i = trails[i].parent)
+            {
+                steps.push_back(trails[i].step);
+            }
+            std::reverse(steps.begin(), steps.end());
+            return decode(steps);
+        }
+
+        std::vector<Trail> trails;
+        SolveArena arena;
+    };
+}
+
+namespace
+{
+    // The LP relaxation bounds every plan. It is only worth its cost when a gap lets the
+    // search stop early, and is shaved slightly so float rounding never lifts it over the optimum.
+    float root_bound(const std::vector<Source> &sources, const std::vector<Cut> &cuts, const SolverOptions &options)
+    {
+        if (options.gap <= 0)
+        {
+            return 0;
+        }
+        return static_cast<float>(solve_lp_relaxation(sources, cuts).cost * (1 - 1e-6));
+    }
+
+    EndState run_engine(std::vector<Source> &sources, std::vector<Cut> &cuts, const SolverOptions &options)
+    {
+        if (options.engine == SolverEngine::column_generation)
+        {
+            return solve_column_generation(sources, cuts);
+        }
+        if (options.engine == SolverEngine::patterns)
+        {
+            return solve_patterns(sources, cuts, options.repeat_patterns);
+        }
+
+        if (options.engine == SolverEngine::parallel_branch_and_bound)
+        {
+            // Column generation gives a near-optimal plan quickly, which the workers then only have to beat
+            ParallelCutSolver solver(sources, options, root_bound(sources, cuts, options), solve_column_generation(sources, cuts));
+            return solver.solve(cuts);
+        }
+
+        if (options.engine == SolverEngine::iterative_deepening)
+        {
+            IterativeDeepeningCutSolver solver(sources, options, root_bound(sources, cuts, options));
+            return solver.solve(cuts);
+        }
+        if (options.engine == SolverEngine::beam)
+        {
+            BeamCutSolver solver(sources, options);
+            return solver.solve(cuts);
+        }
+
+        if (options.open_list == OpenList::binary_heap)
+        {
+            CutSolver<BinaryHeapOpenList> solver(sources, options, root_bound(sources, cuts, options));
+            return solver.solve(cuts);
+        }
+        CutSolver<RadixHeapOpenList> solver(sources, options, root_bound(sources, cuts, options));
+        return solver.solve(cuts);
+    }
+}
+
+EndState solve_cut_problem(std::vector<Source> &sources, std::vector<Cut> &cuts, const SolverOptions &options)
+{
+    ReducedProblem reduced;
+    {
+        PhaseTimer timer(options.stats, &SolverStats::sort_ms);
+        std::sort(cuts.begin(), cuts.end(), CutLengthSorter());
+        std::sort(sources.begin(), sources.end(), SourceLengthSorter());
+        cuts.erase(std::remove_if(cuts.begin(), cuts.end(), [](const Cut &cut)
+                                  { return cut.quantity <= 0; }),
+                   cuts.end());
+
+        // A warm start is a plan for the whole problem, so that is what gets searched
+        reduced = options.warm_start ? ReducedProblem{sources, cuts, EndState{0, 0, {}}} : reduce_problem(sources, cuts);
+    }
+
+    if (reduced.cuts.empty())
+    {
+        return reduced.fixed;
+    }
+
+    if (options.cache)
+    {
+        if (std::optional<EndState> cached = options.cache->find(reduced.sources, reduced.cuts))
+        {
+            reduced.fixed + *cached;
+            return reduced.fixed;
+        }
+    }
+
+    // Plans found along the way are reported whole, with the fixed boards in front
+    SolverOptions search_options = options;
+    if (options.on_incumbent && !reduced.fixed.operations.empty())
+    {
+        search_options.on_incumbent = [&](const EndState &plan)
+        {
+            EndState whole = reduced.fixed;
+            whole + plan;
+            options.on_incumbent(whole);
+        };
+    }
+
+    EndState solution;
+    {
+        // Reconstruction happens inside the search, it is taken back out of the search time
+        const double reconstruction_before = options.stats ? options.stats->reconstruction_ms : 0;
+        PhaseTimer timer(options.stats, &SolverStats::search_ms);
+        solution = run_engine(reduced.sources, reduced.cuts, search_options);
+        if (options.stats)
+        {
+            options.stats->search_ms -= options.stats->reconstruction_ms - reconstruction_before;
+        }
+    }
+
+    if (options.cache)
+    {
+        options.cache->store(reduced.sources, reduced.cuts, solution);
+    }
+    reduced.fixed + solution;
+    return reduced.fixed;
+}
+
+namespace std
+{
+    template <>
+    struct hash<CutBlock>
+    {
+        size_t operator()(const CutBlock &block) const
+        {
+            size_t a = 98230981;
+            hash_combine(a, block.source);
+            for (size_t i = 0; i < block.cut_lengths.size(); i++)
+            {
+                hash_combine(a, block.cut_lengths[i]);
+            }
+            return a;
+        }
+    };
+
+    // Blocks are grouped before their names are looked up, the source tells them apart
+    template <>
+    struct equal_to<CutBlock>
+    {
+        bool operator()(const CutBlock &a, const CutBlock &b) const
+        {
+            return std::equal_to<Source>{}(a.source, b.source) && a.cut_lengths == b.cut_lengths;
+        }
+    };
+}
+
+std::vector<std::pair<CutBlock, size_t>> group_blocks(const Problem &problem, const EndState &solution)
+{
+    const std::vector<Operation> &vec = solution.operations.c;
+    // Nothing to cut, every cut of the problem had a quantity of zero
+    if (vec.empty())
+    {
+        return {};
+    }
+
+    std::unordered_map<CutBlock, size_t> block_count;
+    CutBlock curr_block{std::get<Source>(vec[0]), nullptr, {}};
+
+    // The cut lengths buffer is only copied for a block not seen before
+    auto count_block = [&]()
+    {
+        auto it = block_count.find(curr_block);
+        if (it == block_count.end())
+        {
+            block_count.emplace(curr_block, 1);
+        }
+        else
+        {
+            it->second++;
+        }
+    };
+
+    for (size_t i = 1; i < vec.size(); i++)
+    {
+        if (const Cut *cut = std::get_if<Cut>(&vec[i]))
+        {
+            curr_block.cut_lengths.push_back(cut->length);
+        }
+        else
+        {
+            count_block();
+            curr_block.source = std::get<Source>(vec[i]);
+            curr_block.cut_lengths.clear();
+        }
+    }
+
+    // The last block has no source after it to end it
+    count_block();
+
+    std::vector<std::pair<CutBlock, size_t>> items{block_count.begin(), block_count.end()};
+    for (auto &item : items)
+    {
+        item.first.source_name = &problem.source_names.find(item.first.source)->second;
+    }
+
+    std::sort(items.begin(), items.end(),[](const std::pair<CutBlock, size_t>& a, const std::pair<CutBlock, size_t>& b){
+        return a.first.source.length < b.first.source.length;
+    });
+
+    return items;
+}
+
+namespace
+{
+    // Appends a number the way an ostream with default flags prints it
+    void append_number(std::string &buffer, double value)
+    {
+        char digits[32];
+        const auto end = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::general, 6).ptr;
+        buffer.append(digits, end);
+    }
+
+    void append_count(std::string &buffer, size_t value)
+    {
+        char digits[24];
+        const auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+        buffer.append(digits, end);
+    }
+
+    template <typename T>
+    void append_raw(std::string &buffer, T value)
+    {
+        static_assert(std::endian::native == std::endian::little, "The binary plan format is little-endian");
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        buffer.append(bytes, sizeof(T));
+    }
+
+    void append_raw(std::string &buffer, const std::string &text)
+    {
+        append_raw(buffer, static_cast<uint32_t>(text.size()));
+        buffer += text;
+    }
+
+    // Formatting buffer reused by every plan a thread writes
+    std::string &plan_buffer()
+    {
+        thread_local std::string buffer;
+        buffer.clear();
+        return buffer;
+    }
+}
+
+void output(std::ostream &out, const Problem &problem, const EndState &solution)
+{
+    std::string &buffer = plan_buffer();
+    buffer += "For: ";
+    buffer += problem.tag;
+    buffer += ", Cost: ";
+    append_number(buffer, solution.cost);
+    if (solution.lower_bound < solution.cost)
+    {
+        buffer += ", Gap: ";
+        append_number(buffer, 100 * (solution.cost - solution.lower_bound) / solution.cost);
+        buffer += '%';
+    }
+    buffer += '\n';
+
+    for (const auto &[block, count] : group_blocks(problem, solution))
+    {
+        buffer += "\t(";
+        append_count(buffer, count);
+        buffer += "x) [";
+        buffer += *block.source_name;
+        buffer += ", ";
+        append_number(buffer, source_units(problem, block.source.length));
+        buffer += "] -> [";
+        for (size_t i = 0; i < block.cut_lengths.size(); i++)
+        {
+            append_number(buffer, cut_units(problem, block.cut_lengths[i]));
+            if (i != block.cut_lengths.size() - 1)
+            {
+                buffer += ", ";
+            }
+        }
+        buffer += "]\n";
+    }
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+void output_binary(std::ostream &out, const Problem &problem, const EndState &solution)
+{
+    const auto blocks = group_blocks(problem, solution);
+
+    // Sources in the order the blocks first use them
+    std::vector<const CutBlock *> sources;
+    std::unordered_map<Source, uint32_t> source_index;
+    for (const auto &[block, count] : blocks)
+    {
+        if (source_index.try_emplace(block.source, static_cast<uint32_t>(sources.size())).second)
+        {
+            sources.push_back(&block);
+        }
+    }
+
+    std::string &buffer = plan_buffer();
+    buffer += "CLB1";
+    append_raw(buffer, problem.tag);
+    append_raw(buffer, problem.resolution);
+    append_raw(buffer, solution.cost);
+    append_raw(buffer, solution.lower_bound);
+
+    append_raw(buffer, static_cast<uint32_t>(sources.size()));
+    for (const CutBlock *block : sources)
+    {
+        append_raw(buffer, *block->source_name);
+        append_raw(buffer, block->source.cost);
+        append_raw(buffer, block->source.length);
+    }
+
+    append_raw(buffer, static_cast<uint32_t>(blocks.size()));
+    for (const auto &[block, count] : blocks)
+    {
+        append_raw(buffer, source_index[block.source]);
+    }
+    for (const auto &[block, count] : blocks)
+    {
+        append_raw(buffer, static_cast<uint32_t>(count));
+    }
+    for (const auto &[block, count] : blocks)
+    {
+        append_raw(buffer, static_cast<uint32_t>(block.cut_lengths.size()));
+    }
+    for (const auto &[block, count] : blocks)
+    {
+        for (Length length : block.cut_lengths)
+        {
+            append_raw(buffer, length);
+        }
+    }
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
@@ -0,0 +1,149 @@
+#include "incremental_solver.hpp"
+#include "column_generation.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace
+{
+    struct Board
+    {
+        Source source;
+        std::vector<Cut> cuts;
+    };
+
+    std::vector<Board> split_boards(const Record &operations)
+    {
+        std::vector<Operation> sequence;
+        for (Record record = operations; !record.empty(); record.pop())
+        {
+            sequence.push_back(record.top());
+        }
+
+        std::vector<Board> boards;
+        for (auto it = sequence.rbegin(); it != sequence.rend(); ++it)
+        {
+            if (const Source *source = std::get_if<Source>(&*it))
+            {
+                boards.push_back(Board{*source, {}});
+            }
+            else if (!boards.empty())
+            {
+                boards.back().cuts.push_back(std::get<Cut>(*it));
+            }
+        }
+        return boards;
+    }
+
+    void apply_delta(std::vector<Cut> &cuts, const std::vector<Cut> &delta)
+    {
+        for (const auto &change : delta)
+        {
+            const auto it = std::find_if(cuts.begin(), cuts.end(), [&](const Cut &cut)
+                                         { return cut.length == change.length; });
+            if (it != cuts.end())
+            {
+                it->quantity += change.quantity;
+            }
+            else
+            {
+                cuts.push_back(change);
+            }
+        }
+        cuts.erase(std::remove_if(cuts.begin(), cuts.end(), [](const Cut &cut)
+                                  { return cut.quantity <= 0; }),
+                   cuts.end());
+    }
+}
+
+EndState resolve_cut_problem(std::vector<Source> &sources, std::vector<Cut> &cuts, const std::vector<Cut> &delta,
+                             const EndState &previous, const SolverOptions &options)
+{
+    apply_delta(cuts, delta);
+
+    std::unordered_map<Length, int> open;
+    for (const auto &cut : cuts)
+    {
+        open[cut.length] += cut.quantity;
+    }
+
+    EndState solution{0, 0, {}};
+    for (const auto &board : split_boards(previous.operations))
+    {
+        const bool stocked = std::any_of(sources.begin(), sources.end(), [&](const Source &source)
+                                         { return std::equal_to<Source>{}(source, board.source); });
+        if (!stocked)
+        {
+            continue;
+        }
+
+        std::unordered_map<Length, int> pieces;
+        for (const auto &cut : board.cuts)
+        {
+            pieces[cut.length]++;
+        }
+        const bool wanted = std::all_of(pieces.begin(), pieces.end(), [&](const auto &piece)
+                                        { return open[piece.first] >= piece.second; });
+        if (!wanted)
+        {
+            continue;
+        }
+
+        for (const auto &[length, count] : pieces)
+        {
+            open[length] -= count;
+        }
+        solution.cost += board.source.cost;
+        solution.operations.push(board.source);
+        for (const auto &cut : board.cuts)
+        {
+            solution.operations.push(cut);
+        }
+    }
+
+    std::vector<Cut> remainder;
+    for (const auto &cut : cuts)
+    {
+        if (open[cut.length] > 0)
+        {
+            remainder.push_back(Cut{cut.length, open[cut.length]});
+            open[cut.length] = 0;
+        }
+    }
+    if (!remainder.empty())
+    {
+        solution + solve_cut_problem(sources, remainder, options);
+    }
+
+    if (cuts.empty())
+    {
+        solution.lower_bound = solution.cost;
+        return solution;
+    }
+
+    std::vector<Cut> demand = cuts;
+    std::sort(sources.begin(), sources.end(), [](const Source &a, const Source &b)
+              { return a.length < b.length; });
+    std::sort(demand.begin(), demand.end(), [](const Cut &a, const Cut &b)
+              { return a.length < b.length; });
+    solution.lower_bound = static_cast<float>(solve_lp_relaxation(sources, demand).cost);
+
+    // With a budget to spend, the best-first engine searches the whole new demand
+    // starting from the stitched plan and keeps it unless it finds better
+    const bool budgeted = options.time_limit.count() != 0 || options.node_limit != 0;
+    if (budgeted && options.engine == SolverEngine::best_first && solution.lower_bound < solution.cost)
+    {
+        SolverOptions polish = options;
+        polish.warm_start = &solution;
+        std::vector<Source> all_sources = sources;
+        EndState searched = solve_cut_problem(all_sources, demand, polish);
+        searched.lower_bound = std::max(searched.lower_bound, solution.lower_bound);
+        if (searched.cost <= solution.cost)
+        {
+            solution = std::move(searched);
+        }
+    }
+
+    solution.lower_bound = std::min(solution.cost, solution.lower_bound);
+    return solution;
+}
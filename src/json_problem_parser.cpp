@@ -1,6 +1,9 @@
 #include <fstream>
-#include <set>
 #include <string>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
 
 #include <nlohmann/json.hpp>
 
@@ -10,195 +13,323 @@ using json = nlohmann::json;
 
 namespace
 {
-    struct Source_s
+    // Whole ticks of a length, up for cuts and down for sources so a plan never puts more
+    // on a board than it holds. A quotient within float noise of a tick is that tick.
+    Length to_length(double units, double resolution, bool round_up)
+    {
+        double ticks = units / resolution;
+        const double nearest = std::round(ticks);
+        if (std::fabs(ticks - nearest) <= 1e-9 * std::max(1.0, std::fabs(ticks)))
+        {
+            ticks = nearest;
+        }
+        else
+        {
+            ticks = round_up ? std::ceil(ticks) : std::floor(ticks);
+        }
+        if (!(std::fabs(ticks) <= std::numeric_limits<Length>::max()))
+        {
+            throw problem_feasibility_exception("There is a length too large for the chosen resolution");
+        }
+        return static_cast<Length>(ticks);
+    }
+
+    struct SourceOffer
     {
-        std::string tag;
         std::string name;
         double cost;
-        double length;
     };
 
-    struct Cut_s
+    // Everything read for one tag, keyed by length as written so the file's
+    // resolution may come after its sources and cuts
+    struct TagEntries
     {
-        std::string tag;
-        double length;
-        int quantity;
-        bool operator==(const Cut_s &other) const
-        {
-            return this->tag == other.tag && this->length == other.length && this->quantity == other.quantity;
-        }
+        std::unordered_map<double, SourceOffer> sources;
+        std::unordered_map<double, int> cuts;
     };
 
-    // parse the JSON into vectors of Source_s and Cut_s
-    void parseJSON(const std::string &jsonString, std::vector<Source_s> &sources, std::vector<Cut_s> &cuts)
+    // Folds sources and cuts into per-tag maps as the parser meets them, so memory grows
+    // with the distinct (tag, length) keys and never holds the document. Sources of the
+    // same tag and length keep the cheapest offer, cuts add up their quantities.
+    class ProblemSax : public nlohmann::json_sax<json>
     {
-        // Parse the JSON string
-        json parsed = json::parse(jsonString);
-
-        // Parse sources
-        for (const auto &source : parsed["sources"])
+    public:
+        double resolution = default_resolution;
+        std::string id;
+        std::string cancel;
+        double time_limit = 0;
+        std::unordered_map<std::string, TagEntries> tags;
+
+        bool null() override
         {
-            sources.push_back({source["tag"].get<std::string>(),
-                               source["name"].get<std::string>(),
-                               source["cost"].get<double>(),
-                               source["length"].get<double>()});
+            return true;
         }
 
-        // Parse cuts
-        for (const auto &cut : parsed["cuts"])
+        bool boolean(bool) override
         {
-            cuts.push_back({cut["tag"].get<std::string>(),
-                            cut["length"].get<double>(),
-                            cut["quantity"].get<int>()});
+            return true;
         }
-    }
 
-    std::string read_file(const std::filesystem::path &file)
-    {
-        std::ifstream file_open(file);
-        std::stringstream buffer;
-        buffer << file_open.rdbuf();
-        return buffer.str();
-    }
+        bool number_integer(number_integer_t value) override
+        {
+            if (std::string *text = id_field())
+            {
+                *text = std::to_string(value);
+            }
+            return number(static_cast<double>(value));
+        }
 
-    Problems extract_problems(std::vector<Source_s> &sources, std::vector<Cut_s> &cuts)
-    {
-        std::unordered_map<std::string, Problem> tag_to_problem;
+        bool number_unsigned(number_unsigned_t value) override
+        {
+            if (std::string *text = id_field())
+            {
+                *text = std::to_string(value);
+            }
+            return number(static_cast<double>(value));
+        }
 
-        for (const auto &source : sources)
+        bool number_float(number_float_t value, const string_t &text) override
         {
-            auto iter = tag_to_problem.find(source.tag);
+            if (std::string *id_text = id_field())
+            {
+                *id_text = text;
+            }
+            return number(value);
+        }
 
-            if (iter == tag_to_problem.end())
+        bool string(string_t &value) override
+        {
+            if (std::string *text = id_field())
             {
-                tag_to_problem[source.tag] = Problem{};
-                tag_to_problem[source.tag].tag = source.tag;
-                iter = tag_to_problem.find(source.tag);
+                *text = json(value).dump();
             }
+            else if (in_item())
+            {
+                if (field == "tag")
+                {
+                    item.tag = std::move(value);
+                    item.has_tag = true;
+                }
+                else if (field == "name")
+                {
+                    item.name = std::move(value);
+                    item.has_name = true;
+                }
+            }
+            return true;
+        }
 
-            Problem &prob = iter->second;
-            Source src;
-            src.cost = source.cost;
-            src.length = source.length;
-            prob.sources.emplace_back(src);
-            prob.source_names[src] = source.name;
+        bool binary(binary_t &) override
+        {
+            return true;
         }
 
-        for (const auto &cut : cuts)
+        bool start_object(std::size_t) override
         {
-            auto iter = tag_to_problem.find(cut.tag);
+            depth++;
+            if (in_item())
+            {
+                item = Item{};
+            }
+            return true;
+        }
 
-            if (iter == tag_to_problem.end())
+        bool key(string_t &value) override
+        {
+            if (depth == 1)
+            {
+                section = value;
+            }
+            else if (in_item())
             {
-                tag_to_problem[cut.tag] = Problem{};
-                tag_to_problem[cut.tag].tag = cut.tag;
-                iter = tag_to_problem.find(cut.tag);
+                field = std::move(value);
             }
+            return true;
+        }
 
-            Problem &prob = iter->second;
-            Cut ct;
-            ct.length = cut.length;
-            ct.quantity = cut.quantity;
-            prob.cuts.emplace_back(ct);
+        bool end_object() override
+        {
+            if (in_item())
+            {
+                commit();
+            }
+            depth--;
+            return true;
         }
-        Problems problems;
-        for (auto &problem : tag_to_problem)
+
+        bool start_array(std::size_t) override
         {
-            problems.emplace_back(std::move(problem.second));
+            depth++;
+            return true;
         }
-        return problems;
-    }
 
-    void sanitize_cuts(std::vector<Cut_s> &cuts)
-    {
-        // Only differentiates on tag and length
-        struct Cut_s_compare
+        bool end_array() override
         {
-            bool operator()(const Cut_s &a, const Cut_s &b) const
-            {
-                if (a.tag != b.tag)
-                {
-                    return a.tag < b.tag;
-                }
+            depth--;
+            return true;
+        }
 
-                return a.length < b.length;
-            }
+        bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &ex) override
+        {
+            throw ex;
+        }
+
+    private:
+        struct Item
+        {
+            std::string tag;
+            std::string name;
+            double cost;
+            double length;
+            double quantity;
+            bool has_tag = false;
+            bool has_name = false;
+            bool has_cost = false;
+            bool has_length = false;
+            bool has_quantity = false;
         };
 
-        std::set<Cut_s, Cut_s_compare> set;
-        for (auto &cut : cuts)
+        // The top-level "id" or "cancel" being read, both kept as JSON text
+        std::string *id_field()
         {
-            auto it = set.find(cut);
-            if (it == set.end())
+            if (depth != 1)
             {
-                set.emplace(cut);
+                return nullptr;
             }
-            else
+            if (section == "id")
             {
-                // Resolve collision
-
-                Cut_s combined = *it; // Copy out element in set
-                set.erase(it);
-
-                combined.quantity += cut.quantity; // combine quantities from both cuts
-                set.emplace(combined);
+                return &id;
             }
+            return section == "cancel" ? &cancel : nullptr;
         }
 
-        if (set.size() == cuts.size())
+        // Directly inside one object of the "sources" or "cuts" array
+        bool in_item() const
         {
-            return;
+            return depth == 3 && (section == "sources" || section == "cuts");
         }
 
-        cuts = std::vector<Cut_s>(set.begin(), set.end());
-    };
-
-    void sanitize_sources(std::vector<Source_s> &sources)
-    {
-        // Only differentiates on tag and length
-        // This way the set collides for items with the same tag and length,
-        // Then we can choose the one with the best price
-        struct Source_s_compare
+        bool number(double value)
         {
-            bool operator()(const Source_s &a, const Source_s &b) const
+            if (depth == 1 && section == "resolution")
             {
-                if (a.tag != b.tag)
+                resolution = value;
+            }
+            else if (depth == 1 && section == "time_limit")
+            {
+                time_limit = value;
+            }
+            else if (in_item())
+            {
+                if (field == "cost")
                 {
-                    return a.tag < b.tag;
+                    item.cost = value;
+                    item.has_cost = true;
+                }
+                else if (field == "length")
+                {
+                    item.length = value;
+                    item.has_length = true;
+                }
+                else if (field == "quantity")
+                {
+                    item.quantity = value;
+                    item.has_quantity = true;
                 }
-
-                return a.length < b.length;
             }
-        };
+            return true;
+        }
 
-        std::set<Source_s, Source_s_compare> set;
-        for (auto &source : sources)
+        void commit()
         {
-            auto it = set.find(source);
-
-            if (it == set.end())
+            if (section == "sources")
             {
-                set.emplace(source);
+                if (!item.has_tag || !item.has_name || !item.has_cost || !item.has_length)
+                {
+                    throw problem_feasibility_exception("There is a source missing its tag, name, cost or length");
+                }
+                auto [it, inserted] = tags[item.tag].sources.try_emplace(item.length);
+                if (inserted || item.cost <= it->second.cost)
+                {
+                    it->second = SourceOffer{std::move(item.name), item.cost};
+                }
             }
             else
             {
-                if (it->cost < source.cost)
+                if (!item.has_tag || !item.has_length || !item.has_quantity)
                 {
-                    continue;
+                    throw problem_feasibility_exception("There is a cut missing its tag, length or quantity");
                 }
-                else
+                if (!(item.quantity >= 1 && item.quantity <= std::numeric_limits<int>::max()) || item.quantity != std::floor(item.quantity))
                 {
-                    set.erase(it);
-                    set.emplace(source);
+                    throw problem_feasibility_exception("There is a cut whose quantity is not a positive whole number");
                 }
+                tags[item.tag].cuts[item.length] += static_cast<int>(item.quantity);
             }
         }
-        if (set.size() == sources.size())
+
+        int depth = 0;
+        std::string section;
+        std::string field;
+        Item item;
+    };
+
+    // Rounds every length to the resolution, merging what lands on the same tick. Merged
+    // sources keep the cheapest offer and its length, merged cuts print as the longest.
+    Problems build_problems(ProblemSax &sax)
+    {
+        if (!(sax.resolution > 0))
         {
-            return;
+            throw problem_feasibility_exception("The resolution must be positive");
         }
 
-        sources = std::vector<Source_s>(set.begin(), set.end());
+        Problems problems;
+        problems.reserve(sax.tags.size());
+        for (auto &[tag, entries] : sax.tags)
+        {
+            Problem problem;
+            problem.tag = tag;
+            problem.resolution = sax.resolution;
+
+            std::unordered_map<Length, std::pair<double, SourceOffer>> sources;
+            for (auto &[length, offer] : entries.sources)
+            {
+                auto [it, inserted] = sources.try_emplace(to_length(length, sax.resolution, false), length, offer);
+                if (!inserted && offer.cost <= it->second.second.cost)
+                {
+                    it->second = {length, std::move(offer)};
+                }
+            }
+            for (auto &[length, written] : sources)
+            {
+                auto &[units, offer] = written;
+                Source src;
+                src.cost = offer.cost;
+                src.length = length;
+                problem.sources.emplace_back(src);
+                problem.source_names[src] = std::move(offer.name);
+                problem.written_source_lengths[length] = units;
+            }
+
+            std::unordered_map<Length, int> cuts;
+            for (const auto &[length, quantity] : entries.cuts)
+            {
+                const Length ticks = to_length(length, sax.resolution, true);
+                cuts[ticks] += quantity;
+                double &units = problem.written_cut_lengths[ticks];
+                units = std::max(units, length);
+            }
+            for (const auto &[length, quantity] : cuts)
+            {
+                Cut ct;
+                ct.length = length;
+                ct.quantity = quantity;
+                problem.cuts.emplace_back(ct);
+            }
+
+            problems.emplace_back(std::move(problem));
+        }
+        return problems;
     }
 
     void validate_problem(const Problem &problem)
@@ -212,7 +343,7 @@ namespace
             throw problem_feasibility_exception("There are no cuts available");
         }
 
-        float max_src_len = -1;
+        Length max_src_len = -1;
 
         for (auto &src : problem.sources)
         {
@@ -223,7 +354,7 @@ namespace
             max_src_len = std::max(src.length, max_src_len);
         }
 
-        float max_cut_len = -1;
+        Length max_cut_len = -1;
         for (auto &cut : problem.cuts)
         {
             if (cut.length < 0)
@@ -248,26 +379,39 @@ namespace
     }
 }
 
-Problems parse_problems(const std::string &str)
+ProblemDocument parse_problem_document(const std::string &str)
 {
-    std::vector<Source_s> sources;
-    std::vector<Cut_s> cuts;
+    ProblemSax sax;
+    json::sax_parse(str, &sax);
 
-    parseJSON(str, sources, cuts);
-
-    sanitize_cuts(cuts);
+    if (!(sax.time_limit >= 0))
+    {
+        throw problem_feasibility_exception("The time limit must not be negative");
+    }
 
-    sanitize_sources(sources);
+    ProblemDocument document{std::move(sax.id), build_problems(sax), std::chrono::milliseconds(static_cast<long>(sax.time_limit)), std::move(sax.cancel)};
 
-    auto problems = extract_problems(sources, cuts);
+    validate_problems(document.problems);
 
-    validate_problems(problems);
+    return document;
+}
 
-    return problems;
+Problems parse_problems(const std::string &str)
+{
+    return parse_problem_document(str).problems;
 }
 
 Problems parse_problems(const std::filesystem::path &json_file)
 {
-    std::string contents = read_file(json_file);
-    return parse_problems(contents);
+    // The parser pulls the file through the stream buffer a chunk at a time
+    std::ifstream file_open(json_file, std::ios::binary);
+
+    ProblemSax sax;
+    json::sax_parse(file_open, &sax);
+
+    auto problems = build_problems(sax);
+
+    validate_problems(problems);
+
+    return problems;
 }
@@ -5,31 +5,169 @@
 #include <string_view>
 #include <filesystem>
 #include <algorithm>
-#include <execution>
+#include <thread>
+#include <memory>
+#include <charconv>
+
+#include <nlohmann/json.hpp>
 
 #include "types.hpp"
 #include "json_problem_parser.hpp"
 #include "cut_optimization_solver.hpp"
+#include "batch_solver.hpp"
+#include "ndjson_pipeline.hpp"
+#include "solution_cache.hpp"
+#include "socket_server.hpp"
+
+namespace
+{
+    void usage(const char *program)
+    {
+        std::cerr << "Usage: " << program << " [--cache <dir>] [--gap <fraction>] [--stats] [--binary] <problems.json>\n"
+                  << "       " << program << " [--cache <dir>] [--gap <fraction>] --ndjson [max in flight]\n"
+                  << "       " << program << " [--cache <dir>] [--gap <fraction>] --socket <path>\n";
+    }
+
+    // One line per problem, written to stderr so the plans on stdout stay as they are
+    void print_stats(const Problem &problem, const SolverStats &stats)
+    {
+        const nlohmann::json line = {{"tag", problem.tag},
+                                     {"nodes_generated", stats.nodes_generated},
+                                     {"nodes_expanded", stats.nodes_expanded},
+                                     {"duplicates_pruned", stats.duplicates_pruned},
+                                     {"peak_queue_size", stats.peak_queue_size},
+                                     {"peak_queue_bytes", stats.peak_queue_bytes},
+                                     {"sort_ms", stats.sort_ms},
+                                     {"search_ms", stats.search_ms},
+                                     {"reconstruction_ms", stats.reconstruction_ms}};
+        std::cerr << line.dump() << '\n';
+    }
+
+    // A gap is a fraction of the plan's cost, from 0 up to but not including 1
+    bool parse_gap(std::string_view text, float &gap)
+    {
+        float value;
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc() || end != text.data() + text.size() || !(value >= 0 && value < 1))
+        {
+            return false;
+        }
+        gap = value;
+        return true;
+    }
+
+    // Problems in flight are a whole number of at least 1
+    bool parse_in_flight(std::string_view text, size_t &max_in_flight)
+    {
+        size_t value;
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc() || end != text.data() + text.size() || value == 0)
+        {
+            return false;
+        }
+        max_in_flight = value;
+        return true;
+    }
 
+    constexpr size_t cache_bytes = 256 << 20;
+}
 
-int main()
+int main(int argc, char **argv)
 {
-    std::filesystem::path example1 = "/home/jacobmosier/Cut_List_Calculator/example_problem_specs/test_2.json";
+    std::vector<std::string_view> args(argv + 1, argv + argc);
+
+    SolverOptions options;
+    std::unique_ptr<SolutionCache> cache;
+    bool stats = false;
+    bool binary = false;
+    while (!args.empty())
+    {
+        if (args.size() >= 2 && args[0] == "--cache")
+        {
+            cache = std::make_unique<SolutionCache>(std::filesystem::path(args[1]), cache_bytes);
+            options.cache = cache.get();
+            args.erase(args.begin(), args.begin() + 2);
+        }
+        else if (args.size() >= 2 && args[0] == "--gap")
+        {
+            if (!parse_gap(args[1], options.gap))
+            {
+                usage(argv[0]);
+                return 1;
+            }
+            args.erase(args.begin(), args.begin() + 2);
+        }
+        else if (args[0] == "--stats")
+        {
+            stats = true;
+            args.erase(args.begin());
+        }
+        else if (args[0] == "--binary")
+        {
+            binary = true;
+            args.erase(args.begin());
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (!args.empty() && args[0] == "--ndjson")
+    {
+        size_t max_in_flight = 4 * std::max(1u, std::thread::hardware_concurrency());
+        if (args.size() > 2 || (args.size() == 2 && !parse_in_flight(args[1], max_in_flight)))
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        run_ndjson_pipeline(std::cin, std::cout, options, max_in_flight);
+        return 0;
+    }
 
-    Problems problems = parse_problems(example1);
+    if (args.size() == 2 && args[0] == "--socket")
+    {
+        // Only a socket that cannot be set up or a listener that fails for good gets here
+        try
+        {
+            run_socket_server(std::filesystem::path(args[1]), options);
+        }
+        catch (const std::exception &ex)
+        {
+            std::cerr << ex.what() << '\n';
+            return 1;
+        }
+        return 0;
+    }
 
-    std::vector<EndState> solutions;
-    solutions.reserve(problems.size());
+    if (args.size() != 1)
+    {
+        usage(argv[0]);
+        return 1;
+    }
 
-    std::transform(std::execution::par_unseq, problems.begin(), problems.end(), solutions.begin(), [](Problem &problem)
-                   { return solve_cut_problem(problem.sources, problem.cuts); });
+    std::filesystem::path problem_file = args[0];
+
+    Problems problems = parse_problems(problem_file);
+
+    std::vector<SolverStats> problem_stats;
+    const std::vector<EndState> solutions = solve_problems(problems, options, stats ? &problem_stats : nullptr);
 
     for (size_t i = 0; i < problems.size(); i++)
     {
-        output(std::cout, problems[i], solutions[i]);
+        if (binary)
+        {
+            output_binary(std::cout, problems[i], solutions[i]);
+        }
+        else
+        {
+            output(std::cout, problems[i], solutions[i]);
+        }
+        if (stats)
+        {
+            print_stats(problems[i], problem_stats[i]);
+        }
     }
-    
-
 
     return 0;
 }
@@ -0,0 +1,128 @@
+#include "ndjson_pipeline.hpp"
+#include "json_problem_parser.hpp"
+#include "batch_solver.hpp"
+
+#include <string>
+#include <charconv>
+#include <cstdlib>
+
+#include <nlohmann/json.hpp>
+#include <tbb/parallel_pipeline.h>
+
+using json = nlohmann::json;
+
+namespace
+{
+    struct Job
+    {
+        size_t line;
+        std::string text;
+    };
+
+    // The double nearest the shortest decimal that reads back as the same float,
+    // so costs print as 13.84 rather than 13.84000015258789
+    double shortest(float value)
+    {
+        char buffer[32];
+        const auto end = std::to_chars(buffer, buffer + sizeof(buffer) - 1, value).ptr;
+        *end = '\0';
+        return std::strtod(buffer, nullptr);
+    }
+
+    json solution_json(const Problem &problem, const EndState &solution)
+    {
+        json boards = json::array();
+        for (const auto &[block, count] : group_blocks(problem, solution))
+        {
+            json cuts = json::array();
+            for (Length length : block.cut_lengths)
+            {
+                cuts.push_back(cut_units(problem, length));
+            }
+            boards.push_back({{"count", count},
+                              {"source", *block.source_name},
+                              {"length", source_units(problem, block.source.length)},
+                              {"cuts", std::move(cuts)}});
+        }
+        return {{"tag", problem.tag},
+                {"cost", shortest(solution.cost)},
+                {"lower_bound", shortest(solution.lower_bound)},
+                {"boards", std::move(boards)}};
+    }
+
+    std::string solve_line(const Job &job, const SolverOptions &options)
+    {
+        std::string id = std::to_string(job.line);
+        try
+        {
+            ProblemDocument document = parse_problem_document(job.text);
+            if (!document.id.empty())
+            {
+                id = std::move(document.id);
+            }
+            return solution_line(id, document, options);
+        }
+        catch (const std::exception &ex)
+        {
+            return error_line(id, ex.what());
+        }
+    }
+}
+
+std::string solution_line(const std::string &id, ProblemDocument &document, const SolverOptions &options)
+{
+    SolverOptions document_options = options;
+    if (document.time_limit.count() != 0)
+    {
+        document_options.time_limit = document.time_limit;
+    }
+
+    try
+    {
+        const std::vector<EndState> plans = solve_problems(document.problems, document_options);
+        json solutions = json::array();
+        for (size_t i = 0; i < plans.size(); i++)
+        {
+            solutions.push_back(solution_json(document.problems[i], plans[i]));
+        }
+        return "{\"id\":" + id + ",\"solutions\":" + solutions.dump() + "}";
+    }
+    catch (const std::exception &ex)
+    {
+        return error_line(id, ex.what());
+    }
+}
+
+std::string error_line(const std::string &id, const char *message)
+{
+    return "{\"id\":" + id + ",\"error\":" + json(message).dump() + "}";
+}
+
+void run_ndjson_pipeline(std::istream &in, std::ostream &out, const SolverOptions &options, size_t max_in_flight)
+{
+    size_t line = 0;
+    tbb::parallel_pipeline(
+        max_in_flight,
+        tbb::make_filter<void, Job>(tbb::filter_mode::serial_in_order,
+                                    [&](tbb::flow_control &control)
+                                    {
+                                        Job job{0, {}};
+                                        while (std::getline(in, job.text))
+                                        {
+                                            job.line = ++line;
+                                            if (job.text.find_first_not_of(" \t\r") != std::string::npos)
+                                            {
+                                                return job;
+                                            }
+                                        }
+                                        control.stop();
+                                        return job;
+                                    }) &
+            tbb::make_filter<Job, std::string>(tbb::filter_mode::parallel,
+                                               [&](const Job &job)
+                                               { return solve_line(job, options); }) &
+            tbb::make_filter<std::string, void>(tbb::filter_mode::serial_out_of_order,
+                                                [&](const std::string &result)
+                                                { out << result << '\n'
+                                                      << std::flush; }));
+}
@@ -0,0 +1,360 @@
+#include "pattern_solver.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <queue>
+#include <unordered_map>
+#include <limits>
+#include <stdexcept>
+#include <cstdint>
+
+#include <tbb/parallel_for_each.h>
+
+namespace
+{
+    constexpr size_t pattern_limit = 1 << 20;
+
+    // Depth-first over the cuts, longest first, trying the most pieces of each before fewer
+    class PatternEnumerator
+    {
+    public:
+        PatternEnumerator(const std::vector<Cut> &cuts_, size_t source_, Length capacity_)
+            : cuts(cuts_), source(source_), capacity(capacity_), counts(cuts_.size(), 0) {}
+
+        std::vector<Pattern> enumerate()
+        {
+            search(cuts.size(), capacity);
+            return std::move(patterns);
+        }
+
+    private:
+        void search(size_t item, Length left)
+        {
+            if (item == 0)
+            {
+                if (maximal(left))
+                {
+                    if (patterns.size() >= pattern_limit)
+                    {
+                        throw std::length_error("Pattern enumeration exceeded its pattern limit");
+                    }
+                    patterns.push_back(Pattern{source, counts});
+                }
+                return;
+            }
+
+            const size_t i = item - 1;
+            int most = cuts[i].quantity;
+            if (cuts[i].length > 0)
+            {
+                most = std::min<int>(most, left / cuts[i].length);
+            }
+            for (int count = most; count >= 0; count--)
+            {
+                counts[i] = count;
+                search(i, left - count * cuts[i].length);
+            }
+            counts[i] = 0;
+        }
+
+        bool maximal(Length left) const
+        {
+            bool any = false;
+            for (size_t i = 0; i < cuts.size(); i++)
+            {
+                any |= counts[i] > 0;
+                if (counts[i] < cuts[i].quantity && cuts[i].length <= left)
+                {
+                    return false;
+                }
+            }
+            return any;
+        }
+
+        const std::vector<Cut> &cuts;
+        const size_t source;
+        const Length capacity;
+        std::vector<int> counts;
+        std::vector<Pattern> patterns;
+    };
+
+    int64_t used_length(const Pattern &pattern, const std::vector<Cut> &cuts)
+    {
+        int64_t used = 0;
+        for (size_t i = 0; i < cuts.size(); i++)
+        {
+            used += static_cast<int64_t>(pattern.counts[i]) * cuts[i].length;
+        }
+        return used;
+    }
+
+    // A pattern is dominated when a cheaper source holds it too, ties go to the shorter source
+    bool dominated(const Pattern &pattern, const std::vector<Source> &sources, const std::vector<Cut> &cuts)
+    {
+        const int64_t used = used_length(pattern, cuts);
+        const Source &own = sources[pattern.source];
+        for (size_t s = 0; s < sources.size(); s++)
+        {
+            if (s == pattern.source || sources[s].length < used)
+            {
+                continue;
+            }
+            if (sources[s].cost < own.cost || (sources[s].cost == own.cost && s < pattern.source))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    struct DemandHash
+    {
+        size_t operator()(const std::vector<int> &demand) const
+        {
+            size_t seed = 2654435761;
+            for (int quantity : demand)
+            {
+                hash_combine(seed, quantity);
+            }
+            return seed;
+        }
+    };
+
+    // Same arena layout as the piece-level search: a node keeps the boards it added,
+    // its parent and the interned demand it left
+    struct PlanNode
+    {
+        static constexpr uint32_t no_parent = std::numeric_limits<uint32_t>::max();
+
+        float cost;
+        uint32_t parent;
+        uint32_t pattern;
+        uint32_t repeats;
+        const std::vector<int> *demand;
+    };
+
+    // Boards of a pattern the open demand takes whole, at least one
+    int whole_repeats(const Pattern &pattern, const std::vector<int> &open)
+    {
+        int repeats = std::numeric_limits<int>::max();
+        for (size_t i = 0; i < open.size(); i++)
+        {
+            if (pattern.counts[i] > 0)
+            {
+                repeats = std::min(repeats, open[i] / pattern.counts[i]);
+            }
+        }
+        return std::max(repeats, 1);
+    }
+
+    struct PlanEntry
+    {
+        float cost;
+        uint32_t node;
+    };
+
+    struct PlanEntryCompare
+    {
+        bool operator()(const PlanEntry &a, const PlanEntry &b) const
+        {
+            if (a.cost != b.cost)
+            {
+                return b.cost < a.cost;
+            }
+            return a.node < b.node;
+        }
+    };
+
+    // A* over the demand still open, one board per step. Some board has to take the longest
+    // piece left, so only patterns holding it are tried; the estimate is the open length at
+    // the best price per length. With repeats a step cuts a pattern as often as the open
+    // demand takes it whole instead, which skips every plan using it fewer times.
+    class PatternSearch
+    {
+    public:
+        PatternSearch(const std::vector<Source> &sources_, const std::vector<Cut> &cuts_, std::vector<Pattern> &&patterns_, bool repeats_)
+            : sources(sources_), cuts(cuts_), patterns(std::move(patterns_)), repeats(repeats_), holding(cuts_.size())
+        {
+            for (size_t p = 0; p < patterns.size(); p++)
+            {
+                for (size_t i = 0; i < cuts.size(); i++)
+                {
+                    if (patterns[p].counts[i] > 0)
+                    {
+                        holding[i].push_back(static_cast<uint32_t>(p));
+                    }
+                }
+            }
+
+            cost_per_length = std::numeric_limits<float>::infinity();
+            for (const auto &source : sources)
+            {
+                if (source.length > 0)
+                {
+                    cost_per_length = std::min(cost_per_length, source.cost / static_cast<float>(source.length));
+                }
+            }
+        }
+
+        EndState solve()
+        {
+            std::vector<int> demand(cuts.size());
+            for (size_t i = 0; i < cuts.size(); i++)
+            {
+                demand[i] = cuts[i].quantity;
+            }
+
+            const auto root = best_cost.emplace(std::move(demand), 0.0f).first;
+            nodes.push_back(PlanNode{0, PlanNode::no_parent, 0, 0, &root->first});
+
+            root_estimate = estimate(root->first);
+            std::priority_queue<PlanEntry, std::vector<PlanEntry>, PlanEntryCompare> queue;
+            queue.push(PlanEntry{root_estimate, 0});
+
+            while (!queue.empty())
+            {
+                const uint32_t index = queue.top().node;
+                queue.pop();
+
+                const PlanNode node = nodes[index];
+                const std::vector<int> &open = *node.demand;
+
+                if (node.cost > best_cost.find(open)->second)
+                {
+                    continue;
+                }
+
+                size_t longest = open.size();
+                while (longest > 0 && open[longest - 1] == 0)
+                {
+                    longest--;
+                }
+                if (longest == 0)
+                {
+                    return reconstruct(index);
+                }
+
+                for (uint32_t p : holding[longest - 1])
+                {
+                    const int times = repeats ? whole_repeats(patterns[p], open) : 1;
+                    std::vector<int> child = open;
+                    for (size_t i = 0; i < child.size(); i++)
+                    {
+                        child[i] = std::max(0, child[i] - times * patterns[p].counts[i]);
+                    }
+
+                    const float cost = node.cost + times * sources[patterns[p].source].cost;
+                    auto [it, inserted] = best_cost.try_emplace(std::move(child), cost);
+                    if (!inserted)
+                    {
+                        if (it->second <= cost)
+                        {
+                            continue;
+                        }
+                        it->second = cost;
+                    }
+
+                    if (nodes.size() >= PlanNode::no_parent)
+                    {
+                        throw std::length_error("Pattern solver exceeded its node limit");
+                    }
+                    nodes.push_back(PlanNode{cost, index, p, static_cast<uint32_t>(times), &it->first});
+                    queue.push(PlanEntry{cost + estimate(it->first), static_cast<uint32_t>(nodes.size() - 1)});
+                }
+            }
+            throw std::runtime_error("There is a cut that no pattern holds");
+        }
+
+    private:
+        float estimate(const std::vector<int> &open) const
+        {
+            int64_t length = 0;
+            for (size_t i = 0; i < open.size(); i++)
+            {
+                length += static_cast<int64_t>(cuts[i].length) * open[i];
+            }
+            return static_cast<float>(length) * cost_per_length;
+        }
+
+        EndState reconstruct(uint32_t index) const
+        {
+            std::vector<std::pair<Pattern, int>> plan;
+            for (uint32_t i = index; nodes[i].parent != PlanNode::no_parent; i = nodes[i].parent)
+            {
+                plan.emplace_back(patterns[nodes[i].pattern], static_cast<int>(nodes[i].repeats));
+            }
+            std::reverse(plan.begin(), plan.end());
+            EndState end_state = expand_plan(sources, cuts, plan);
+            // Repeats leave plans unsearched, so only the estimate of the whole demand is proven
+            end_state.lower_bound = repeats ? std::min(end_state.cost, root_estimate) : end_state.cost;
+            return end_state;
+        }
+
+        const std::vector<Source> &sources;
+        const std::vector<Cut> &cuts;
+        const std::vector<Pattern> patterns;
+        const bool repeats;
+        // Patterns holding at least one piece of each cut
+        std::vector<std::vector<uint32_t>> holding;
+        float cost_per_length;
+        float root_estimate;
+        std::vector<PlanNode> nodes;
+        std::unordered_map<std::vector<int>, float, DemandHash> best_cost;
+    };
+}
+
+std::vector<Pattern> enumerate_patterns(const std::vector<Source> &sources, const std::vector<Cut> &cuts)
+{
+    std::vector<std::vector<Pattern>> per_source(sources.size());
+    std::vector<size_t> indices(sources.size());
+    std::iota(indices.begin(), indices.end(), 0);
+
+    // TBB rethrows a worker's exception on the calling thread, a parallel std algorithm would terminate
+    tbb::parallel_for_each(indices.begin(), indices.end(), [&](size_t s)
+                           {
+                               std::vector<Pattern> found = PatternEnumerator(cuts, s, sources[s].length).enumerate();
+                               std::erase_if(found, [&](const Pattern &pattern)
+                                             { return dominated(pattern, sources, cuts); });
+                               per_source[s] = std::move(found); });
+
+    std::vector<Pattern> patterns;
+    for (auto &found : per_source)
+    {
+        patterns.insert(patterns.end(), std::make_move_iterator(found.begin()), std::make_move_iterator(found.end()));
+    }
+    return patterns;
+}
+
+EndState expand_plan(const std::vector<Source> &sources, const std::vector<Cut> &cuts, const std::vector<std::pair<Pattern, int>> &plan)
+{
+    std::vector<int> remaining(cuts.size());
+    for (size_t i = 0; i < cuts.size(); i++)
+    {
+        remaining[i] = cuts[i].quantity;
+    }
+
+    EndState end_state;
+    end_state.cost = 0;
+    for (const auto &[pattern, uses] : plan)
+    {
+        for (int use = 0; use < uses; use++)
+        {
+            end_state.cost += sources[pattern.source].cost;
+            end_state.operations.push(sources[pattern.source]);
+            for (size_t i = cuts.size(); i-- > 0;)
+            {
+                for (int count = 0; count < pattern.counts[i] && remaining[i] > 0; count++)
+                {
+                    end_state.operations.push(cuts[i]);
+                    remaining[i]--;
+                }
+            }
+        }
+    }
+    return end_state;
+}
+
+EndState solve_patterns(const std::vector<Source> &sources, const std::vector<Cut> &cuts, bool repeats)
+{
+    return PatternSearch(sources, cuts, enumerate_patterns(sources, cuts), repeats).solve();
+}
@@ -0,0 +1,122 @@
+#include "problem_reduction.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+
+namespace
+{
+    // Scanning from the longest source down, a source is kept only when it is cheaper than
+    // every longer one kept, so the sources left cost strictly more the longer they are
+    std::vector<Source> drop_dominated(std::vector<Source> sources)
+    {
+        // Among equal lengths the cheapest is seen first
+        std::sort(sources.begin(), sources.end(), [](const Source &a, const Source &b)
+                  { return a.length != b.length ? a.length < b.length : a.cost > b.cost; });
+
+        std::vector<Source> kept;
+        float cheapest = std::numeric_limits<float>::infinity();
+        for (auto it = sources.rbegin(); it != sources.rend(); ++it)
+        {
+            if (it->cost < cheapest)
+            {
+                kept.push_back(*it);
+                cheapest = it->cost;
+            }
+        }
+        std::reverse(kept.begin(), kept.end());
+        return kept;
+    }
+
+    // With dominated sources gone the shortest source that holds a length is also the cheapest
+    const Source *cheapest_holding(const std::vector<Source> &sources, int64_t length)
+    {
+        const auto it = std::find_if(sources.begin(), sources.end(), [&](const Source &source)
+                                     { return source.length >= length; });
+        return it != sources.end() ? &*it : nullptr;
+    }
+
+    void add_pieces(EndState &fixed, const Cut &cut, int pieces)
+    {
+        for (int piece = 0; piece < pieces; piece++)
+        {
+            fixed.operations.push(cut);
+        }
+    }
+
+    // Shortest piece still open other than one piece of cuts[i]
+    Length shortest_other(const std::vector<Cut> &cuts, size_t i)
+    {
+        for (size_t j = 0; j < cuts.size(); j++)
+        {
+            if (cuts[j].quantity > (j == i ? 1 : 0))
+            {
+                return cuts[j].length;
+            }
+        }
+        return std::numeric_limits<Length>::max();
+    }
+}
+
+ReducedProblem reduce_problem(const std::vector<Source> &sources, const std::vector<Cut> &cuts)
+{
+    ReducedProblem reduced{drop_dominated(sources), cuts, EndState{0, 0, {}}};
+    if (reduced.sources.empty())
+    {
+        return reduced;
+    }
+    const Length longest_source = reduced.sources.back().length;
+
+    // Taking pieces out only makes the shortest other piece longer, so repeat until nothing moves
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (size_t i = reduced.cuts.size(); i-- > 0;)
+        {
+            Cut &cut = reduced.cuts[i];
+            if (cut.quantity == 0 || cut.length > longest_source ||
+                longest_source - cut.length >= shortest_other(reduced.cuts, i))
+            {
+                continue;
+            }
+
+            const Source &board = *cheapest_holding(reduced.sources, cut.length);
+            for (int piece = 0; piece < cut.quantity; piece++)
+            {
+                reduced.fixed.cost += board.cost;
+                reduced.fixed.operations.push(board);
+                add_pieces(reduced.fixed, cut, 1);
+            }
+            cut.quantity = 0;
+            changed = true;
+        }
+    }
+
+    std::erase_if(reduced.cuts, [](const Cut &cut)
+                  { return cut.quantity == 0; });
+
+    if (!reduced.cuts.empty())
+    {
+        int64_t total = 0;
+        for (const auto &cut : reduced.cuts)
+        {
+            total += static_cast<int64_t>(cut.length) * cut.quantity;
+        }
+
+        // Every plan buys a board that holds the longest cut, this one holds everything
+        const Source *board = cheapest_holding(reduced.sources, reduced.cuts.back().length);
+        if (board && board->length >= total)
+        {
+            reduced.fixed.cost += board->cost;
+            reduced.fixed.operations.push(*board);
+            for (auto it = reduced.cuts.rbegin(); it != reduced.cuts.rend(); ++it)
+            {
+                add_pieces(reduced.fixed, *it, it->quantity);
+            }
+            reduced.cuts.clear();
+        }
+    }
+
+    reduced.fixed.lower_bound = reduced.fixed.cost;
+    return reduced;
+}
@@ -0,0 +1,281 @@
+#include "socket_server.hpp"
+#include "ndjson_pipeline.hpp"
+#include "json_problem_parser.hpp"
+#include "solution_cache.hpp"
+
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <stdexcept>
+#include <system_error>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <tbb/task_arena.h>
+
+namespace
+{
+    // One client. Its solves hold it too, so the socket is closed once the reader has
+    // seen the end and the last answer has been written.
+    class Connection
+    {
+    public:
+        explicit Connection(int fd_) : fd(fd_) {}
+
+        ~Connection()
+        {
+            close(fd);
+        }
+
+        // One line without its newline, false once the client is done sending
+        bool read_line(std::string &line)
+        {
+            for (;;)
+            {
+                const size_t end = buffer.find('\n');
+                if (end != std::string::npos)
+                {
+                    line.assign(buffer, 0, end);
+                    buffer.erase(0, end + 1);
+                    return true;
+                }
+
+                char chunk[1 << 16];
+                const ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+                if (received < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (received <= 0)
+                {
+                    // The last line may come without a newline
+                    line = std::move(buffer);
+                    buffer.clear();
+                    return !line.empty();
+                }
+                buffer.append(chunk, static_cast<size_t>(received));
+            }
+        }
+
+        // Answers for a client that has gone are dropped
+        void write_line(const std::string &line)
+        {
+            const std::string message = line + '\n';
+            std::lock_guard<std::mutex> lock(write_mutex);
+            for (size_t sent = 0; sent < message.size();)
+            {
+                const ssize_t written = send(fd, message.data() + sent, message.size() - sent, MSG_NOSIGNAL);
+                if (written < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (written <= 0)
+                {
+                    return;
+                }
+                sent += static_cast<size_t>(written);
+            }
+        }
+
+        std::shared_ptr<std::atomic<bool>> start_request(const std::string &id)
+        {
+            auto cancelled = std::make_shared<std::atomic<bool>>(false);
+            std::lock_guard<std::mutex> lock(requests_mutex);
+            requests[id] = cancelled;
+            return cancelled;
+        }
+
+        void finish_request(const std::string &id, const std::shared_ptr<std::atomic<bool>> &cancelled)
+        {
+            std::lock_guard<std::mutex> lock(requests_mutex);
+            // A later document may have reused the id
+            const auto it = requests.find(id);
+            if (it != requests.end() && it->second == cancelled)
+            {
+                requests.erase(it);
+            }
+        }
+
+        void cancel(const std::string &id)
+        {
+            std::lock_guard<std::mutex> lock(requests_mutex);
+            const auto it = requests.find(id);
+            if (it != requests.end())
+            {
+                it->second->store(true, std::memory_order_relaxed);
+            }
+        }
+
+        void cancel_all()
+        {
+            std::lock_guard<std::mutex> lock(requests_mutex);
+            for (auto &[id, cancelled] : requests)
+            {
+                cancelled->store(true, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        const int fd;
+        std::string buffer;
+        std::mutex write_mutex;
+        std::mutex requests_mutex;
+        std::unordered_map<std::string, std::shared_ptr<std::atomic<bool>>> requests;
+    };
+
+    // Parses on the connection's own thread, so cancels are seen while solves run,
+    // and hands every document to the shared pool
+    void serve(std::shared_ptr<Connection> connection, tbb::task_arena &arena, const SolverOptions &options)
+    {
+        std::string text;
+        for (size_t line = 1; connection->read_line(text); line++)
+        {
+            if (text.find_first_not_of(" \t\r") == std::string::npos)
+            {
+                continue;
+            }
+
+            std::string id = std::to_string(line);
+            auto document = std::make_shared<ProblemDocument>();
+            try
+            {
+                *document = parse_problem_document(text);
+            }
+            catch (const std::exception &ex)
+            {
+                connection->write_line(error_line(id, ex.what()));
+                continue;
+            }
+            catch (...)
+            {
+                connection->write_line(error_line(id, "The document could not be read"));
+                continue;
+            }
+
+            if (!document->cancel.empty())
+            {
+                connection->cancel(document->cancel);
+                continue;
+            }
+            if (!document->id.empty())
+            {
+                id = document->id;
+            }
+
+            auto cancelled = connection->start_request(id);
+            const auto received = std::chrono::steady_clock::now();
+            arena.enqueue([connection, document, id, cancelled, received, &options]
+                          {
+                              // The time limit counts from when the document came in, not from when a worker took it
+                              if (document->time_limit.count() != 0)
+                              {
+                                  const auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - received);
+                                  document->time_limit = std::max(document->time_limit - waited, std::chrono::milliseconds(1));
+                              }
+
+                              SolverOptions request_options = options;
+                              request_options.cancel = cancelled.get();
+                              // Whatever one request throws is answered to it, an exception leaving a pool task would end the server
+                              try
+                              {
+                                  connection->write_line(solution_line(id, *document, request_options));
+                              }
+                              catch (...)
+                              {
+                                  connection->write_line(error_line(id, "The request could not be solved"));
+                              }
+                              connection->finish_request(id, cancelled); });
+        }
+        connection->cancel_all();
+    }
+
+    // A failure on one connection drops that connection, never the server
+    void serve_guarded(std::shared_ptr<Connection> connection, tbb::task_arena &arena, const SolverOptions &options)
+    {
+        try
+        {
+            serve(connection, arena, options);
+        }
+        catch (...)
+        {
+            connection->cancel_all();
+        }
+    }
+
+    [[noreturn]] void throw_errno(const char *what)
+    {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    constexpr std::chrono::milliseconds accept_backoff(50);
+
+    constexpr size_t memory_cache_bytes = 64 << 20;
+}
+
+void run_socket_server(const std::filesystem::path &socket_path, const SolverOptions &options)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    const std::string name = socket_path.string();
+    if (name.size() >= sizeof(address.sun_path))
+    {
+        throw std::invalid_argument("The socket path is too long");
+    }
+    std::memcpy(address.sun_path, name.c_str(), name.size() + 1);
+
+    const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+    {
+        throw_errno("Could not create the socket");
+    }
+
+    // A socket file left behind by an earlier server is replaced
+    std::filesystem::remove(socket_path);
+    if (bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0 || listen(listener, SOMAXCONN) < 0)
+    {
+        const int error = errno;
+        close(listener);
+        throw std::system_error(error, std::generic_category(), "Could not listen on " + name);
+    }
+
+    // Without a cache directory the server still keeps its plans warm for later requests
+    SolverOptions server_options = options;
+    std::unique_ptr<SolutionCache> memory_cache;
+    if (!options.cache)
+    {
+        memory_cache = std::make_unique<SolutionCache>(memory_cache_bytes);
+        server_options.cache = memory_cache.get();
+    }
+
+    tbb::task_arena arena(options.threads == 0 ? tbb::task_arena::automatic : static_cast<int>(options.threads));
+    for (;;)
+    {
+        const int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0)
+        {
+            const int error = errno;
+            if (error == EINTR || error == ECONNABORTED)
+            {
+                continue;
+            }
+            // Out of descriptors or memory for now, connections that finish give them back
+            if (error == EMFILE || error == ENFILE || error == ENOMEM || error == ENOBUFS)
+            {
+                std::this_thread::sleep_for(accept_backoff);
+                continue;
+            }
+            close(listener);
+            throw std::system_error(error, std::generic_category(), "Could not accept a connection");
+        }
+        std::thread(serve_guarded, std::make_shared<Connection>(fd), std::ref(arena), std::cref(server_options)).detach();
+    }
+}
@@ -0,0 +1,337 @@
+#include "solution_cache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <system_error>
+
+#include <unistd.h>
+
+namespace
+{
+    constexpr const char *magic = "cutlist-plan";
+    constexpr int format_version = 1;
+
+    // Numbers the temporary files of this process, the pid tells processes sharing a directory apart
+    std::atomic<uint64_t> temporary_count{0};
+
+    struct CanonicalProblem
+    {
+        std::vector<Source> sources;
+        std::vector<Cut> cuts;
+    };
+
+    CanonicalProblem canonical(const std::vector<Source> &sources, const std::vector<Cut> &cuts)
+    {
+        CanonicalProblem problem{sources, cuts};
+        std::sort(problem.sources.begin(), problem.sources.end(), [](const Source &a, const Source &b)
+                  { return a.length != b.length ? a.length < b.length : a.cost < b.cost; });
+        std::sort(problem.cuts.begin(), problem.cuts.end(), [](const Cut &a, const Cut &b)
+                  { return a.length != b.length ? a.length < b.length : a.quantity < b.quantity; });
+        return problem;
+    }
+
+    std::filesystem::path entry_path(const std::filesystem::path &directory, const CanonicalProblem &problem)
+    {
+        size_t seed = std::hash<std::vector<Cut>>{}(problem.cuts);
+        for (const auto &source : problem.sources)
+        {
+            hash_combine(seed, source);
+        }
+
+        std::ostringstream name;
+        name << std::hex << seed << ".plan";
+        return directory / name.str();
+    }
+
+    // Costs are written as their bit patterns so they read back exactly
+    uint32_t bits(float value)
+    {
+        return std::bit_cast<uint32_t>(value);
+    }
+
+    std::string serialize(const CanonicalProblem &problem, const EndState &solution)
+    {
+        std::ostringstream out;
+        out << magic << ' ' << format_version << '\n';
+
+        out << problem.sources.size() << '\n';
+        for (const auto &source : problem.sources)
+        {
+            out << bits(source.cost) << ' ' << source.length << '\n';
+        }
+        out << problem.cuts.size() << '\n';
+        for (const auto &cut : problem.cuts)
+        {
+            out << cut.length << ' ' << cut.quantity << '\n';
+        }
+
+        out << bits(solution.cost) << ' ' << bits(solution.lower_bound) << '\n';
+
+        // Operations refer to the sources and cuts above by index. Cut operations only
+        // carry a length that matters, the quantity is what was left when it was placed.
+        std::vector<Operation> operations;
+        for (Record record = solution.operations; !record.empty(); record.pop())
+        {
+            operations.push_back(record.top());
+        }
+        out << operations.size() << '\n';
+        for (auto it = operations.rbegin(); it != operations.rend(); ++it)
+        {
+            if (const Source *source = std::get_if<Source>(&*it))
+            {
+                const auto found = std::find_if(problem.sources.begin(), problem.sources.end(), [&](const Source &candidate)
+                                                { return std::equal_to<Source>{}(candidate, *source); });
+                out << "s " << found - problem.sources.begin() << '\n';
+            }
+            else
+            {
+                const Length length = std::get<Cut>(*it).length;
+                const auto found = std::find_if(problem.cuts.begin(), problem.cuts.end(), [&](const Cut &candidate)
+                                                { return candidate.length == length; });
+                out << "c " << found - problem.cuts.begin() << '\n';
+            }
+        }
+        return out.str();
+    }
+
+    std::optional<EndState> deserialize(std::istream &in, const CanonicalProblem &problem)
+    {
+        std::string header;
+        int version;
+        if (!(in >> header >> version) || header != magic || version != format_version)
+        {
+            return std::nullopt;
+        }
+
+        size_t count;
+        if (!(in >> count) || count != problem.sources.size())
+        {
+            return std::nullopt;
+        }
+        for (const auto &source : problem.sources)
+        {
+            uint32_t cost;
+            Length length;
+            if (!(in >> cost >> length) || cost != bits(source.cost) || length != source.length)
+            {
+                return std::nullopt;
+            }
+        }
+        if (!(in >> count) || count != problem.cuts.size())
+        {
+            return std::nullopt;
+        }
+        for (const auto &cut : problem.cuts)
+        {
+            Length length;
+            int quantity;
+            if (!(in >> length >> quantity) || length != cut.length || quantity != cut.quantity)
+            {
+                return std::nullopt;
+            }
+        }
+
+        uint32_t cost, lower_bound;
+        if (!(in >> cost >> lower_bound >> count))
+        {
+            return std::nullopt;
+        }
+        EndState solution{std::bit_cast<float>(cost), std::bit_cast<float>(lower_bound), {}};
+        for (size_t i = 0; i < count; i++)
+        {
+            char kind;
+            size_t index;
+            if (!(in >> kind >> index))
+            {
+                return std::nullopt;
+            }
+            if (kind == 's' && index < problem.sources.size())
+            {
+                solution.operations.push(problem.sources[index]);
+            }
+            else if (kind == 'c' && index < problem.cuts.size())
+            {
+                solution.operations.push(problem.cuts[index]);
+            }
+            else
+            {
+                return std::nullopt;
+            }
+        }
+        return solution;
+    }
+}
+
+SolutionCache::SolutionCache(std::filesystem::path directory_, size_t max_bytes_)
+    : directory(std::move(directory_)), max_bytes(max_bytes_), total_bytes(0)
+{
+    std::filesystem::create_directories(directory);
+    for (const auto &entry : std::filesystem::directory_iterator(directory))
+    {
+        if (entry.is_regular_file() && entry.path().extension() == ".plan")
+        {
+            total_bytes += entry.file_size();
+        }
+    }
+}
+
+SolutionCache::SolutionCache(size_t max_bytes_)
+    : max_bytes(max_bytes_), total_bytes(0) {}
+
+std::optional<EndState> SolutionCache::find(const std::vector<Source> &sources, const std::vector<Cut> &cuts)
+{
+    const CanonicalProblem problem = canonical(sources, cuts);
+    const std::filesystem::path path = entry_path(directory, problem);
+
+    if (directory.empty())
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = memory.find(path.string());
+        if (it == memory.end())
+        {
+            return std::nullopt;
+        }
+        std::istringstream in(it->second.contents);
+        std::optional<EndState> solution = deserialize(in, problem);
+        if (solution)
+        {
+            it->second.used = ++uses;
+        }
+        return solution;
+    }
+
+    std::ifstream in(path);
+    if (!in)
+    {
+        return std::nullopt;
+    }
+    std::optional<EndState> solution = deserialize(in, problem);
+    if (solution)
+    {
+        // The write time doubles as the last use for eviction
+        std::error_code ignored;
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ignored);
+    }
+    return solution;
+}
+
+void SolutionCache::store(const std::vector<Source> &sources, const std::vector<Cut> &cuts, const EndState &solution)
+{
+    if (solution.lower_bound < solution.cost)
+    {
+        return;
+    }
+
+    const CanonicalProblem problem = canonical(sources, cuts);
+    const std::filesystem::path path = entry_path(directory, problem);
+    const std::string contents = serialize(problem, solution);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (directory.empty())
+    {
+        MemoryEntry &entry = memory[path.string()];
+        total_bytes = total_bytes - entry.contents.size() + contents.size();
+        entry = MemoryEntry{contents, ++uses};
+        if (total_bytes > max_bytes)
+        {
+            evict_memory();
+        }
+        return;
+    }
+
+    // Written aside and renamed in place, so readers never see half an entry.
+    // Each writer gets its own temporary, other caches may share the directory.
+    std::filesystem::path temporary = path;
+    temporary += "." + std::to_string(getpid()) + "." + std::to_string(temporary_count++) + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out << contents;
+        if (!out)
+        {
+            return;
+        }
+    }
+
+    std::error_code error;
+    const uintmax_t replaced = std::filesystem::exists(path, error) ? std::filesystem::file_size(path, error) : 0;
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+        return;
+    }
+
+    total_bytes = total_bytes - std::min<uintmax_t>(total_bytes, replaced) + contents.size();
+    if (total_bytes > max_bytes)
+    {
+        evict();
+    }
+}
+
+void SolutionCache::evict()
+{
+    struct Entry
+    {
+        std::filesystem::path path;
+        std::filesystem::file_time_type used;
+        uintmax_t size;
+    };
+
+    std::vector<Entry> entries;
+    total_bytes = 0;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error))
+    {
+        if (entry.is_regular_file(error) && entry.path().extension() == ".plan")
+        {
+            entries.push_back(Entry{entry.path(), entry.last_write_time(error), entry.file_size(error)});
+            total_bytes += entries.back().size;
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b)
+              { return a.used < b.used; });
+
+    // Down to three quarters of the limit so the next few stores do not evict again
+    const size_t target = max_bytes - max_bytes / 4;
+    for (const auto &entry : entries)
+    {
+        if (total_bytes <= target)
+        {
+            break;
+        }
+        if (std::filesystem::remove(entry.path, error))
+        {
+            total_bytes -= entry.size;
+        }
+    }
+}
+
+void SolutionCache::evict_memory()
+{
+    std::vector<std::pair<uint64_t, std::string>> entries;
+    for (const auto &[name, entry] : memory)
+    {
+        entries.emplace_back(entry.used, name);
+    }
+    std::sort(entries.begin(), entries.end());
+
+    // Down to three quarters of the limit, as on disk
+    const size_t target = max_bytes - max_bytes / 4;
+    for (const auto &[used, name] : entries)
+    {
+        if (total_bytes <= target)
+        {
+            break;
+        }
+        const auto it = memory.find(name);
+        total_bytes -= it->second.contents.size();
+        memory.erase(it);
+    }
+}
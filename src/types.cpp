@@ -2,40 +2,51 @@
 
 #define json_tag(tag) "\"" #tag "\":"
 
-void output(std::ostream &out, const Source &src, const std::string &name)
+namespace
 {
-    out << '{';
-    out << json_tag(name) << "\"" << name << "\",\n";
-    out << json_tag(cost) << src.cost << ",\n";
-    out << json_tag(length) << src.length << "\n}";
+    double written_units(const std::unordered_map<Length, double> &written, Length length, double resolution)
+    {
+        const auto it = written.find(length);
+        return it != written.end() ? it->second : to_units(length, resolution);
+    }
+}
+
+double source_units(const Problem &problem, Length length)
+{
+    return written_units(problem.written_source_lengths, length, problem.resolution);
+}
+
+double cut_units(const Problem &problem, Length length)
+{
+    return written_units(problem.written_cut_lengths, length, problem.resolution);
 }
 
-std::ostream &operator<<(std::ostream &out, const Source &src)
+void output(std::ostream &out, const Source &src, const std::string &name, double length)
 {
     out << '{';
+    out << json_tag(name) << "\"" << name << "\",\n";
     out << json_tag(cost) << src.cost << ",\n";
-    out << json_tag(length) << src.length << "\n}";
-    return out;
+    out << json_tag(length) << length << "\n}";
 }
 
-std::ostream &operator<<(std::ostream &out, const Cut &cut)
+void output(std::ostream &out, const Cut &cut, double length)
 {
     out << '{';
-    out << json_tag(length) << cut.length << ",\n";
+    out << json_tag(length) << length << ",\n";
     out << json_tag(quantity) << cut.quantity << "\n";
     out << '}';
-    return out;
 }
 
 std::ostream &operator<<(std::ostream &out, const Problem &problem)
 {
     out << '{';
     out << json_tag(tag) << "\"" << problem.tag << "\"" << ",\n";
+    out << json_tag(resolution) << problem.resolution << ",\n";
     out << json_tag(sources) << "[";
     for (size_t i = 0; i < problem.sources.size(); i++)
     {
         const auto &source = problem.sources[i];
-        output(out, source, problem.source_names.find(source)->second);
+        output(out, source, problem.source_names.find(source)->second, source_units(problem, source.length));
 
         if (i != problem.sources.size() - 1)
         {
@@ -47,7 +58,7 @@ std::ostream &operator<<(std::ostream &out, const Problem &problem)
     out << json_tag(cuts) << "[";
     for (size_t i = 0; i < problem.cuts.size(); i++)
     {
-        out << problem.cuts[i];
+        output(out, problem.cuts[i], cut_units(problem, problem.cuts[i].length));
 
         if (i != problem.cuts.size() - 1)
         {